@@ -0,0 +1,106 @@
+#ifndef BOID_RENDERER_HPP
+#define BOID_RENDERER_HPP
+
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "FixedTimestep.hpp"
+#include "FlockState.hpp"
+
+
+// Draws a whole flock with one draw call. Every boid is a textured quad (two
+// triangles) in a single vertex array. Its corners are rotated on the CPU
+// the way an sf::Sprite with its origin at the texture center and rotation
+// orientation * 180 / PI would be, so the picture is the same as drawing one
+// sprite per boid.
+class BoidRenderer {
+public:
+    static const std::size_t verticesPerBoid = 6;
+
+    BoidRenderer(const sf::Texture& texture, float scale = 1.f)
+        : texture(texture), vertices(sf::Triangles), drawCalls(0)
+    {
+        sf::Vector2u size = texture.getSize();
+        halfWidth = size.x * scale / 2.f;
+        halfHeight = size.y * scale / 2.f;
+        texWidth = static_cast<float>(size.x);
+        texHeight = static_cast<float>(size.y);
+    }
+
+    void update(const FlockState& flock) {
+        update(flock.columns());
+    }
+
+    void update(const FlockColumns& flock) {
+        vertices.resize(flock.count * verticesPerBoid);
+        for (std::size_t i = 0; i < flock.count; ++i)
+            setQuad(i, sf::Vector2f(flock.x[i], flock.y[i]), flock.orientation[i]);
+    }
+
+    // Boids alpha of the way from previous to current; see interpolateKinematic.
+    void update(const FlockState& previous, const FlockState& current, float alpha, float maxJump) {
+        update(previous.columns(), current.columns(), alpha, maxJump);
+    }
+
+    void update(const FlockColumns& previous, const FlockColumns& current, float alpha, float maxJump) {
+        vertices.resize(current.count * verticesPerBoid);
+        for (std::size_t i = 0; i < current.count; ++i) {
+            Kinematic shown = interpolateKinematic(pose(previous, i), pose(current, i), alpha, maxJump);
+            setQuad(i, shown.position, shown.orientation);
+        }
+    }
+
+    void draw(sf::RenderTarget& target) {
+        if (vertices.getVertexCount() == 0)
+            return;
+        target.draw(vertices, &texture);
+        drawCalls++;
+    }
+
+    const sf::VertexArray& getVertices() const { return vertices; }
+
+    // Draw calls issued since construction: one per draw(), whatever N is.
+    std::size_t getDrawCallCount() const { return drawCalls; }
+
+private:
+    const sf::Texture& texture;
+    sf::VertexArray vertices;
+    std::size_t drawCalls;
+    float halfWidth;
+    float halfHeight;
+    float texWidth;
+    float texHeight;
+
+    static Kinematic pose(const FlockColumns& flock, std::size_t i) {
+        Kinematic k;
+        k.position = sf::Vector2f(flock.x[i], flock.y[i]);
+        k.velocity = sf::Vector2f(0.f, 0.f);
+        k.orientation = flock.orientation[i];
+        k.rotation = 0.f;
+        return k;
+    }
+
+    void setQuad(std::size_t boid, const sf::Vector2f& position, float orientation) {
+        float c = std::cos(orientation);
+        float s = std::sin(orientation);
+        // Corners relative to the center, clockwise from top-left, rotated
+        // like sf::Transform::rotate (y points down).
+        sf::Vector2f ax(c * halfWidth, s * halfWidth);
+        sf::Vector2f ay(-s * halfHeight, c * halfHeight);
+        sf::Vector2f topLeft = position - ax - ay;
+        sf::Vector2f topRight = position + ax - ay;
+        sf::Vector2f bottomRight = position + ax + ay;
+        sf::Vector2f bottomLeft = position - ax + ay;
+
+        sf::Vertex* quad = &vertices[boid * verticesPerBoid];
+        quad[0] = sf::Vertex(topLeft, sf::Vector2f(0.f, 0.f));
+        quad[1] = sf::Vertex(topRight, sf::Vector2f(texWidth, 0.f));
+        quad[2] = sf::Vertex(bottomRight, sf::Vector2f(texWidth, texHeight));
+        quad[3] = sf::Vertex(topLeft, sf::Vector2f(0.f, 0.f));
+        quad[4] = sf::Vertex(bottomRight, sf::Vector2f(texWidth, texHeight));
+        quad[5] = sf::Vertex(bottomLeft, sf::Vector2f(0.f, texHeight));
+    }
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef COUNTER_RANDOM_HPP
+#define COUNTER_RANDOM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COUNTER_RANDOM_X86 1
+#include <immintrin.h>
+#endif
+
+
+// Counter-based random numbers (Philox2x32-10, Salmon et al., "Parallel
+// Random Numbers: As Easy as 1, 2, 3"). A sample is a pure function of
+// (key, counter), so there is no shared generator state. Agents can draw on
+// any thread, in any order, and get the same numbers for the same seed. The
+// key selects a stream (the agent), the counter's two words are the draw
+// index and the seed.
+inline std::uint64_t philox2x32(std::uint32_t counter0, std::uint32_t counter1, std::uint32_t key) {
+    for (int round = 0; round < 10; ++round) {
+        std::uint64_t product = static_cast<std::uint64_t>(0xD256D193u) * counter0;
+        counter0 = static_cast<std::uint32_t>(product >> 32) ^ key ^ counter1;
+        counter1 = static_cast<std::uint32_t>(product);
+        key += 0x9E3779B9u;
+    }
+    return (static_cast<std::uint64_t>(counter0) << 32) | counter1;
+}
+
+// Top 24 bits of a word as a float in [0, 1).
+inline float unitFloat(std::uint32_t bits) {
+    return static_cast<float>(bits >> 8) * (1.f / 16777216.f);
+}
+
+// One sample in (-1, 1), more likely near 0: the difference of two uniforms,
+// both taken from one Philox block.
+inline float binomialAt(std::uint32_t stream, std::uint32_t index, std::uint32_t seed) {
+    std::uint64_t bits = philox2x32(index, seed, stream);
+    return unitFloat(static_cast<std::uint32_t>(bits >> 32)) - unitFloat(static_cast<std::uint32_t>(bits));
+}
+
+#ifdef COUNTER_RANDOM_X86
+// Eight streams per iteration: the 32x32->64 multiplies of even and odd
+// lanes are done separately and their halves blended back together.
+// Bit-identical to the scalar loop.
+__attribute__((target("avx2")))
+inline std::size_t fillBinomialAvx2(std::uint32_t firstStream, std::size_t count,
+                                    std::uint32_t index, std::uint32_t seed, float* out) {
+    const __m256i multiplier = _mm256_set1_epi32(static_cast<int>(0xD256D193u));
+    const __m256i weyl = _mm256_set1_epi32(static_cast<int>(0x9E3779B9u));
+    const __m256 scale = _mm256_set1_ps(1.f / 16777216.f);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i c0 = _mm256_set1_epi32(static_cast<int>(index));
+        __m256i c1 = _mm256_set1_epi32(static_cast<int>(seed));
+        __m256i key = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(firstStream + i)), lanes);
+        for (int round = 0; round < 10; ++round) {
+            __m256i even = _mm256_mul_epu32(c0, multiplier);
+            __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(c0, 32), multiplier);
+            __m256i hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+            __m256i lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+            c0 = _mm256_xor_si256(_mm256_xor_si256(hi, key), c1);
+            c1 = lo;
+            key = _mm256_add_epi32(key, weyl);
+        }
+        __m256 u0 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(c0, 8)), scale);
+        __m256 u1 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(c1, 8)), scale);
+        _mm256_storeu_ps(out + i, _mm256_sub_ps(u0, u1));
+    }
+    return i;
+}
+#endif
+
+// out[i] = binomialAt(firstStream + i, index, seed): draw index of count
+// consecutive agents at once, e.g. one wander sample per agent for a frame.
+// Uses AVX2 when the CPU has it, with identical results.
+inline void fillBinomial(std::uint32_t firstStream, std::size_t count,
+                         std::uint32_t index, std::uint32_t seed, float* out) {
+    std::size_t i = 0;
+#ifdef COUNTER_RANDOM_X86
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    if (avx2)
+        i = fillBinomialAvx2(firstStream, count, index, seed, out);
+#endif
+    for (; i < count; ++i)
+        out[i] = binomialAt(firstStream + static_cast<std::uint32_t>(i), index, seed);
+}
+
+
+// One agent's stream: the same numbers as binomialAt(stream, 0, seed),
+// binomialAt(stream, 1, seed), ... The position can be saved and restored
+// with tell()/seek().
+class RandomStream {
+public:
+    RandomStream(std::uint32_t stream = 0, std::uint32_t seed = 0)
+        : stream(stream), seed(seed), index(0)
+    {}
+
+    float binomial() {
+        return binomialAt(stream, index++, seed);
+    }
+
+    std::uint32_t getStream() const { return stream; }
+    std::uint32_t getSeed() const { return seed; }
+    std::uint32_t tell() const { return index; }
+    void seek(std::uint32_t position) { index = position; }
+
+private:
+    std::uint32_t stream;
+    std::uint32_t seed;
+    std::uint32_t index;
+};
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef DEMO_OPTIONS_HPP
+#define DEMO_OPTIONS_HPP
+
+#include <SFML/System.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+// Command line shared by every demo binary:
+//   --headless      step the simulation without a window or texture
+//   --boids N       number of agents (default: the demo's own count)
+//   --frames N      frames to run headless (default 600)
+//   --dt S          fixed timestep in seconds for headless runs (default 1/60)
+//   --seed N        random seed for headless runs (default 1)
+//   --threads N     simulation threads where the demo is multithreaded
+//   --pipelined     simulate and render on separate threads (flocking demos)
+//   --profile FILE  write a Chrome trace of the frame phases to FILE and print
+//                   their percentiles at exit (flocking demos; see Profiler.hpp)
+//   --record FILE   write every frame of the boids to FILE (see
+//                   TrajectoryRecorder.hpp and KinematicRecording.hpp)
+//   --record-deltas store velocities as quantized deltas between keyframes
+//   --replay FILE   play a recorded FILE instead of simulating (see
+//                   ReplayDemo.hpp)
+//   --save-state FILE   snapshot the whole simulation to FILE at exit
+//   --load-state FILE   start from a snapshot instead of random spawns
+//                       (flocking demos; see Snapshot.hpp)
+//   --lod           recompute the steering of isolated and off-screen boids
+//                   only every few frames (flocking demos; see SteeringLod.hpp)
+//   --steer-budget N    at most about N steering updates per frame; implies --lod
+struct DemoOptions {
+    bool headless = false;
+    int boids = 0;
+    int frames = 600;
+    float dt = 1.f / 60.f;
+    unsigned seed = 1;
+    int threads = 0;
+    bool pipelined = false;
+    const char* profile = nullptr;
+    const char* record = nullptr;
+    bool recordDeltas = false;
+    const char* replay = nullptr;
+    const char* saveState = nullptr;
+    const char* loadState = nullptr;
+    bool lod = false;
+    int steerBudget = 0;
+
+    int boidsOr(int fallback) const { return boids > 0 ? boids : fallback; }
+};
+
+inline DemoOptions parseDemoOptions(int argc, char** argv) {
+    DemoOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--headless") == 0) {
+            options.headless = true;
+        } else if (std::strcmp(arg, "--pipelined") == 0) {
+            options.pipelined = true;
+        } else if (std::strcmp(arg, "--record-deltas") == 0) {
+            options.recordDeltas = true;
+        } else if (std::strcmp(arg, "--lod") == 0) {
+            options.lod = true;
+        } else if (value && std::strcmp(arg, "--boids") == 0) {
+            options.boids = std::atoi(value); ++i;
+        } else if (value && std::strcmp(arg, "--frames") == 0) {
+            options.frames = std::atoi(value); ++i;
+        } else if (value && std::strcmp(arg, "--dt") == 0) {
+            options.dt = static_cast<float>(std::atof(value)); ++i;
+        } else if (value && std::strcmp(arg, "--seed") == 0) {
+            options.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10)); ++i;
+        } else if (value && std::strcmp(arg, "--threads") == 0) {
+            options.threads = std::atoi(value); ++i;
+        } else if (value && std::strcmp(arg, "--profile") == 0) {
+            options.profile = value; ++i;
+        } else if (value && std::strcmp(arg, "--record") == 0) {
+            options.record = value; ++i;
+        } else if (value && std::strcmp(arg, "--replay") == 0) {
+            options.replay = value; ++i;
+        } else if (value && std::strcmp(arg, "--save-state") == 0) {
+            options.saveState = value; ++i;
+        } else if (value && std::strcmp(arg, "--load-state") == 0) {
+            options.loadState = value; ++i;
+        } else if (value && std::strcmp(arg, "--steer-budget") == 0) {
+            options.steerBudget = std::atoi(value); ++i;
+            options.lod = true;
+        } else {
+            std::fprintf(stderr, "ignoring unknown option '%s'\n", arg);
+        }
+    }
+    return options;
+}
+
+
+// FNV-1a over the bit patterns of the simulated state, so two runs agree
+// only if every float matches exactly.
+class StateChecksum {
+public:
+    StateChecksum() : hash(14695981039346656037ull) {}
+
+    void add(float value) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (int i = 0; i < 4; ++i) {
+            hash ^= (bits >> (8 * i)) & 0xffu;
+            hash *= 1099511628211ull;
+        }
+    }
+
+    void add(const sf::Vector2f& v) {
+        add(v.x);
+        add(v.y);
+    }
+
+    // Works with either Kinematic layout (Steering.hpp or VelocityMatching.hpp).
+    template <typename K>
+    void addKinematic(const K& k) {
+        add(k.position);
+        add(k.velocity);
+        add(k.orientation);
+        add(k.rotation);
+    }
+
+    std::uint64_t value() const { return hash; }
+
+private:
+    std::uint64_t hash;
+};
+
+
+// Wall-clock timer for headless runs.
+class HeadlessTimer {
+public:
+    HeadlessTimer() : start(std::chrono::steady_clock::now()) {}
+
+    double seconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+inline void reportHeadless(const char* demo, const DemoOptions& options, int agents,
+                           double seconds, std::uint64_t checksum) {
+    double updates = static_cast<double>(agents) * options.frames;
+    std::printf("%s: %d agents x %d frames (dt %.4f s, seed %u) in %.3f s\n",
+                demo, agents, options.frames, options.dt, options.seed, seconds);
+    std::printf("  throughput: %.3e agent-updates/s\n", seconds > 0.0 ? updates / seconds : 0.0);
+    std::printf("  checksum:   %016llx\n", static_cast<unsigned long long>(checksum));
+}
+
+#endif
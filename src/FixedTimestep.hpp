@@ -0,0 +1,66 @@
+#ifndef FIXED_TIMESTEP_HPP
+#define FIXED_TIMESTEP_HPP
+
+#include <SFML/System.hpp>
+#include <cmath>
+#include <limits>
+
+
+// Fixed-step simulation clock. Each frame, advance() adds the measured
+// frame time to an accumulator and returns how many steps of getStep()
+// seconds to simulate. The simulation therefore only ever sees one dt,
+// however irregular the frames are. After a hitch it catches up by at most
+// maxSteps steps and drops the rest of the backlog, so a long stall slows
+// the simulation down instead of making it explode. getAlpha() says how far
+// the clock is between the last step and the next one, for rendering with
+// interpolateKinematic().
+class FixedTimestep {
+public:
+    FixedTimestep(float step = 1.f / 60.f, int maxSteps = 5)
+        : step(step), maxSteps(maxSteps), accumulator(0.f)
+    {}
+
+    int advance(float frameTime) {
+        accumulator += frameTime;
+        int steps = static_cast<int>(accumulator / step);
+        if (steps > maxSteps) {
+            steps = maxSteps;
+            accumulator = 0.f;
+            return steps;
+        }
+        accumulator -= steps * step;
+        return steps;
+    }
+
+    float getStep() const { return step; }
+    float getAlpha() const { return accumulator / step; }
+
+private:
+    float step;
+    int maxSteps;
+    float accumulator;
+};
+
+
+// previous blended into current by alpha in [0, 1]. Orientation turns the
+// short way round. A position that moved more than maxJump in one step
+// (e.g. wrapped to the other edge of the window) is not blended. Works for
+// either Kinematic layout (Steering.hpp or VelocityMatching.hpp).
+template <typename K>
+K interpolateKinematic(const K& previous, const K& current, float alpha,
+                       float maxJump = std::numeric_limits<float>::infinity()) {
+    const float pi = 3.14159265f;
+    K out = current;
+    sf::Vector2f move = current.position - previous.position;
+    if (std::abs(move.x) <= maxJump && std::abs(move.y) <= maxJump)
+        out.position = previous.position + move * alpha;
+    out.velocity = previous.velocity + (current.velocity - previous.velocity) * alpha;
+    float turn = current.orientation - previous.orientation;
+    while (turn > pi) turn -= 2.f * pi;
+    while (turn < -pi) turn += 2.f * pi;
+    out.orientation = previous.orientation + turn * alpha;
+    out.rotation = previous.rotation + (current.rotation - previous.rotation) * alpha;
+    return out;
+}
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef FLOCK_BATCH_HPP
+#define FLOCK_BATCH_HPP
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "FlockSimulation.hpp"
+
+
+// Many independent small flocks ("worlds") stepped together, e.g. thousands
+// of 100-boid worlds for training or evaluation runs. Every world's boids
+// sit in one contiguous range of shared struct-of-arrays state, so a step is
+// a single parallel pass over ranges of worlds with no per-world allocation
+// or synchronization.
+//
+// Boids behave as in FlockSimulation with the linear neighbor scan (the
+// grid and neighbor-list settings are ignored), limited to their own world:
+// the scan is the SIMD range kernel over the world's boids, which is cheap
+// at these sizes. Each world has its own bounds and wander seed, and boid k
+// of a world wanders on stream k, so a world steps bit for bit like a
+// FlockSimulation holding only its boids, wherever it sits in the batch.
+class FlockBatch {
+public:
+    // Boids per task; small worlds are grouped until a task has about this many.
+    static const std::size_t agentsPerTask = 1024;
+
+    FlockBatch(const FlockParams& params, int threadCount = 0)
+        : params(params), jobs(threadCount), unranged(0)
+    {}
+
+    FlockBatch(const FlockBatch&) = delete;
+    FlockBatch& operator=(const FlockBatch&) = delete;
+
+    // Starts an empty world and returns its index; addBoid() fills the most
+    // recently added world. Without bounds it uses the params' window.
+    std::size_t addWorld(unsigned seed) {
+        return addWorld(seed, params.worldWidth, params.worldHeight);
+    }
+
+    std::size_t addWorld(unsigned seed, float width, float height) {
+        worlds.push_back(World{ current.size(), current.size(), width, height, seed });
+        return worlds.size() - 1;
+    }
+
+    void addBoid(const Kinematic& k) {
+        World& world = worlds.back();
+        current.push_back(k);
+        next.push_back(k);
+        steerings.push_back(SteeringOutput());
+        behaviors.push_back(makeBehavior());
+        behaviors.back().seedWander(world.seed, static_cast<unsigned>(world.end - world.begin));
+        world.end++;
+        // The world's range is handed to its boids once, at the next step.
+        unranged = std::min(unranged, worlds.size() - 1);
+    }
+
+    // Steers and integrates every world, then makes the new frame current.
+    void step(float deltaTime) {
+        if (worlds.empty())
+            return;
+        applyRanges();
+        std::size_t grain = std::max<std::size_t>(1, agentsPerTask * worlds.size() / std::max<std::size_t>(1, size()));
+        jobs.parallelFor(worlds.size(), grain, [this, deltaTime](std::size_t begin, std::size_t end) {
+            ProfileScope scope("batch");
+            for (std::size_t w = begin; w < end; ++w)
+                stepWorld(worlds[w], deltaTime);
+        });
+        current.swap(next);
+    }
+
+    const FlockState& state() const { return current; }
+    std::size_t size() const { return current.size(); }
+    std::size_t worldCount() const { return worlds.size(); }
+    // Boids of world w are [worldBegin(w), worldEnd(w)) of state().
+    std::size_t worldBegin(std::size_t w) const { return worlds[w].begin; }
+    std::size_t worldEnd(std::size_t w) const { return worlds[w].end; }
+    std::size_t worldSize(std::size_t w) const { return worlds[w].end - worlds[w].begin; }
+    float getWorldWidth(std::size_t w) const { return worlds[w].width; }
+    float getWorldHeight(std::size_t w) const { return worlds[w].height; }
+    unsigned getWorldSeed(std::size_t w) const { return worlds[w].seed; }
+
+    FlockColumns worldColumns(std::size_t w) const {
+        const World& world = worlds[w];
+        return FlockColumns{ current.x.data() + world.begin, current.y.data() + world.begin,
+                             current.orientation.data() + world.begin, world.end - world.begin };
+    }
+
+    const FlockParams& getParams() const { return params; }
+    int getThreadCount() const { return jobs.getThreadCount(); }
+
+private:
+    struct World {
+        std::size_t begin, end;  // boids in the shared state
+        float width, height;
+        unsigned seed;
+    };
+
+    FlockParams params;
+    JobSystem jobs;
+    std::vector<World> worlds;
+    FlockState current;  // every world's boids, world after world
+    FlockState next;
+    std::vector<FlockingBehavior> behaviors;
+    std::vector<SteeringOutput> steerings;
+    std::size_t unranged;  // first world whose boids lack its final range
+
+    void applyRanges() {
+        for (std::size_t w = unranged; w < worlds.size(); ++w)
+            for (std::size_t i = worlds[w].begin; i < worlds[w].end; ++i)
+                behaviors[i].setNeighborRange(worlds[w].begin, worlds[w].end);
+        unranged = worlds.size();
+    }
+
+    // Worlds share nothing, so a world is steered and integrated in one go:
+    // steering reads only current and integration writes only next. The two
+    // loops stay apart so each keeps its own code and data hot.
+    void stepWorld(const World& world, float deltaTime) {
+        for (std::size_t i = world.begin; i < world.end; ++i)
+            steerings[i] = behaviors[i].getSteering(i, deltaTime);
+        for (std::size_t i = world.begin; i < world.end; ++i)
+            integrateBoid(current, next, i, steerings[i], deltaTime, params.maxSpeed, world.width, world.height);
+    }
+
+    FlockingBehavior makeBehavior() {
+        FlockingBehavior behavior(&current,
+                                  params.neighborRadius, params.separationRadius,
+                                  params.separationWeight, params.alignmentWeight, params.cohesionWeight,
+                                  params.maxAccel,
+                                  params.wanderMaxAccel, params.wanderMaxSpeed, params.wanderOffset,
+                                  params.wanderRadius, params.wanderRate, params.wanderTimeToTarget);
+        if (params.useSimdKernel)
+            behavior.setSimdLevel(detectSimdLevel());
+        return behavior;
+    }
+};
+
+#endif
@@ -0,0 +1,369 @@
+#ifndef FLOCK_DEMO_HPP
+#define FLOCK_DEMO_HPP
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "BoidRenderer.hpp"
+#include "DemoOptions.hpp"
+#include "FixedTimestep.hpp"
+#include "FlockSimulation.hpp"
+#include "FramePipeline.hpp"
+#include "ReplayDemo.hpp"
+#include "TrailBuffer.hpp"
+#include "TrajectoryRecorder.hpp"
+
+// Everything part4a/part4b differ in.
+struct FlockDemoConfig {
+    FlockParams params;
+    int numBoids;
+    float initialSpeed;
+    const char* title;
+};
+
+// What the render thread needs to draw one frame in pipelined mode.
+struct FlockFrame {
+    FlockState previous;
+    FlockState current;
+    float alpha = 0.f;  // how far to draw the boids from previous to current
+    TrailBuffer trails;
+};
+
+// Simulation side of the flocking demos: the flock plus its breadcrumbs.
+// Every boid leaves 10 crumbs, the first after 0.1 s and then one every
+// 0.3 s; a crumb fades out over the time its trail takes to wrap around.
+class FlockDemo {
+public:
+    FlockDemo(const FlockDemoConfig& config, int threadCount)
+        : config(config), simulation(config.params, threadCount), boidTrails(0, 10, 0.3f, 0.1f),
+          recorder(nullptr)
+    {
+        TrailStyle style;
+        style.fadeTime = 10 * 0.3f;
+        boidTrails.setStyle(style);
+    }
+
+    void spawn() {
+        const FlockParams& params = config.params;
+        const int width = static_cast<int>(params.worldWidth);
+        const int height = static_cast<int>(params.worldHeight);
+        unsigned wanderSeed = static_cast<unsigned>(std::rand());
+        for (int i = 0; i < config.numBoids; ++i)
+        {
+            Kinematic k;
+            k.position = sf::Vector2f(static_cast<float>(std::rand() % width),
+                                      static_cast<float>(std::rand() % height));
+            float angle = (std::rand() % 360) * (PI / 180.f);
+            k.velocity = sf::Vector2f(std::cos(angle), std::sin(angle)) * config.initialSpeed;
+            k.orientation = angle;
+            k.rotation = 0.f;
+            simulation.addBoid(k, wanderSeed);
+            boidTrails.addTrail();
+        }
+    }
+
+    // Steering, integration and breadcrumbs run as chunked tasks; each
+    // chunk's crumbs drop as soon as that chunk has moved.
+    void step(float deltaTime) {
+        ProfileScope scope("frame");
+        boidTrails.advance(deltaTime);
+        TaskGraph frame;
+        FlockSimulation::FrameTasks tasks = simulation.schedule(frame, deltaTime);
+        for (std::size_t c = 0; c < tasks.integrated.size(); ++c)
+        {
+            std::size_t begin = c * FlockSimulation::chunkSize;
+            std::size_t end = std::min(simulation.size(), begin + FlockSimulation::chunkSize);
+            TaskGraph::TaskId trail = frame.add([this, begin, end]
+            {
+                dropCrumbs(begin, end);
+            });
+            frame.precede(tasks.integrated[c], trail);
+        }
+        simulation.getJobs().run(frame);
+        if (simulation.commit())
+            boidTrails.permute(simulation.getOrder());
+        if (recorder)
+            recordFrame();
+    }
+
+    // Records the current state and every stepped one from now on; nullptr
+    // stops recording. Call after spawn().
+    void setRecorder(TrajectoryRecorder* trajectory) {
+        recorder = trajectory;
+        if (recorder)
+            recordFrame();
+    }
+
+    void capture(FlockFrame& frame) const {
+        ProfileScope scope("capture");
+        frame.previous = simulation.previous();
+        frame.current = simulation.state();
+        frame.trails.copyForDrawing(boidTrails);
+    }
+
+    // Flock and breadcrumbs, for load() to continue where this left off.
+    bool save(const char* path) const {
+        SnapshotWriter out(path);
+        simulation.save(out);
+        boidTrails.save(out);
+        return out.close();
+    }
+
+    // Instead of spawn().
+    bool load(const char* path) {
+        SnapshotReader in(path);
+        return simulation.load(in) && boidTrails.load(in);
+    }
+
+    const FlockState& state() const { return simulation.state(); }
+    const FlockState& previous() const { return simulation.previous(); }
+    // Where each boid is in state(), by spawn order.
+    const std::vector<std::uint32_t>& getSlots() const { return simulation.getSlots(); }
+    void setView(const sf::FloatRect& view) { simulation.setView(view); }
+    const SteeringLod& getLod() const { return simulation.getLod(); }
+    TrailBuffer& trails() { return boidTrails; }
+    const FlockDemoConfig& getConfig() const { return config; }
+
+private:
+    FlockDemoConfig config;
+    FlockSimulation simulation;
+    TrailBuffer boidTrails;
+    TrajectoryRecorder* recorder;
+
+    // In spawn order, so a boid keeps its place in the file across sorts.
+    void recordFrame() {
+        if (simulation.isSorting())
+            recorder->record(simulation.state(), simulation.getSlots());
+        else
+            recorder->record(simulation.state());
+    }
+
+    void dropCrumbs(std::size_t begin, std::size_t end) {
+        ProfileScope scope("trails");
+        const FlockState& moved = simulation.stepped();
+        for (std::size_t i = begin; i < end; ++i)
+            boidTrails.update(i, moved.position(i));
+    }
+};
+
+
+// The recorder asked for by --record, or nullptr.
+inline std::unique_ptr<TrajectoryRecorder> openRecorder(const FlockDemoConfig& config, const DemoOptions& options,
+                                                        float dt, unsigned seed)
+{
+    if (!options.record)
+        return nullptr;
+    TrajectoryHeader header = TrajectoryHeader::make(config.numBoids, dt, seed, formatFlockParams(config.params));
+    header.worldWidth = config.params.worldWidth;
+    header.worldHeight = config.params.worldHeight;
+    TrajectoryRecorder::Options recording;
+    recording.velocityDeltas = options.recordDeltas;
+    std::unique_ptr<TrajectoryRecorder> recorder(new TrajectoryRecorder(options.record, header, recording));
+    if (!recorder->isOpen()) {
+        std::fprintf(stderr, "cannot write trajectory to '%s'\n", options.record);
+        return nullptr;
+    }
+    return recorder;
+}
+
+// Restores --load-state, or spawns a new flock; config.numBoids follows the
+// snapshot.
+inline bool startFlockDemo(FlockDemo& demo, FlockDemoConfig& config, const DemoOptions& options)
+{
+    if (!options.loadState) {
+        demo.spawn();
+        return true;
+    }
+    HeadlessTimer timer;
+    if (!demo.load(options.loadState)) {
+        std::fprintf(stderr, "cannot restore '%s'\n", options.loadState);
+        return false;
+    }
+    config.numBoids = static_cast<int>(demo.state().size());
+    std::printf("restored %d boids from %s in %.1f ms\n", config.numBoids, options.loadState,
+                timer.seconds() * 1e3);
+    return true;
+}
+
+inline void reportLod(const SteeringLod& lod)
+{
+    if (!lod.isEnabled() || lod.getAgentFrameCount() == 0)
+        return;
+    std::printf("  steering:   %.1f%% of agent-frames updated, longest gap %llu frames (interval %llu)\n",
+                100.0 * lod.getUpdateCount() / lod.getAgentFrameCount(),
+                static_cast<unsigned long long>(lod.getLongestGap()),
+                static_cast<unsigned long long>(lod.getLongestInterval()));
+}
+
+// Writes --save-state, if asked for.
+inline void finishFlockDemo(const FlockDemo& demo, const DemoOptions& options)
+{
+    if (options.saveState && !demo.save(options.saveState))
+        std::fprintf(stderr, "cannot save '%s'\n", options.saveState);
+}
+
+// Options are described in DemoOptions.hpp.
+inline int runFlockDemo(FlockDemoConfig config, int argc, char** argv)
+{
+    DemoOptions options = parseDemoOptions(argc, argv);
+    if (options.replay)
+        return runReplay(options);
+    config.numBoids = options.boidsOr(config.numBoids);
+    if (options.lod)
+    {
+        config.params.lod.enabled = true;
+        config.params.lod.budget = options.steerBudget;
+    }
+    ProfileReport profile(options.profile);  // outlives every demo and its threads
+
+    if (options.headless)
+    {
+        std::srand(options.seed);
+        FlockDemo demo(config, options.threads);
+        if (!startFlockDemo(demo, config, options))
+            return -1;
+        std::unique_ptr<TrajectoryRecorder> recorder = openRecorder(config, options, options.dt, options.seed);
+        demo.setRecorder(recorder.get());
+        HeadlessTimer timer;
+        for (int frame = 0; frame < options.frames; ++frame)
+            demo.step(options.dt);
+        double seconds = timer.seconds();
+
+        // In spawn order, as the boids are recorded.
+        StateChecksum checksum;
+        const FlockState& flock = demo.state();
+        for (std::uint32_t slot : demo.getSlots())
+            checksum.addKinematic(flock.get(slot));
+        reportHeadless(config.title, options, config.numBoids, seconds, checksum.value());
+        reportTrails(demo.trails());
+        reportLod(demo.getLod());
+        if (recorder)
+            reportRecording(*recorder, options.record, seconds - recorder->getRecordSeconds());
+        finishFlockDemo(demo, options);
+        return 0;
+    }
+
+    const unsigned seed = static_cast<unsigned int>(std::time(nullptr));
+    std::srand(seed);
+
+    sf::Texture boidTexture;
+    if (!boidTexture.loadFromFile("src/boid-sm.png"))
+    {
+        return -1;
+    }
+
+    FlockDemo demo(config, options.threads);
+    if (!startFlockDemo(demo, config, options))
+        return -1;
+    // Windowed steps follow the fixed timestep.
+    std::unique_ptr<TrajectoryRecorder> recorder = openRecorder(config, options, FixedTimestep().getStep(), seed);
+    demo.setRecorder(recorder.get());
+
+    BoidRenderer boids(boidTexture);
+    // Boids that moved further than this in one step wrapped around.
+    const float wrapJump = std::min(config.params.worldWidth, config.params.worldHeight) / 2.f;
+
+    const unsigned windowWidth = static_cast<unsigned>(config.params.worldWidth);
+    const unsigned windowHeight = static_cast<unsigned>(config.params.worldHeight);
+    sf::RenderWindow window(sf::VideoMode(windowWidth, windowHeight), config.title);
+    window.setFramerateLimit(60);
+    // The window shows the whole wrap-around world, so nothing is culled as
+    // off screen here; only isolation and the budget lower the update rate.
+    demo.setView(sf::FloatRect(0.f, 0.f, static_cast<float>(windowWidth), static_cast<float>(windowHeight)));
+
+    if (!options.pipelined)
+    {
+        sf::Clock clock;
+        FixedTimestep timestep;
+        while (window.isOpen())
+        {
+            sf::Event event;
+            while (window.pollEvent(event))
+            {
+                if (event.type == sf::Event::Closed)
+                    window.close();
+            }
+
+            int steps = timestep.advance(clock.restart().asSeconds());
+            for (int i = 0; i < steps; ++i)
+                demo.step(timestep.getStep());
+
+            {
+                ProfileScope scope("draw");
+                window.clear(sf::Color::White);
+
+                demo.trails().draw(window);
+                boids.update(demo.previous(), demo.state(), timestep.getAlpha(), wrapJump);
+                boids.draw(window);
+            }
+
+            ProfileScope scope("display");
+            window.display();
+        }
+        finishFlockDemo(demo, options);
+        return 0;
+    }
+
+    // Pipelined: the simulation thread fills frame N+1 while this thread
+    // draws frame N. Both only touch the flock through FlockFrame copies.
+    // Each display draws the newest finished frame and hands any older ones
+    // straight back, so the picture is at most one frame behind.
+    FramePipeline<FlockFrame> pipeline(3);
+    std::thread simulationThread([&]
+    {
+        sf::Clock clock;
+        FixedTimestep timestep;
+        while (FlockFrame* frame = pipeline.acquire())
+        {
+            int steps = timestep.advance(clock.restart().asSeconds());
+            for (int i = 0; i < steps; ++i)
+                demo.step(timestep.getStep());
+            demo.capture(*frame);
+            frame->alpha = timestep.getAlpha();
+            pipeline.publish(frame);
+        }
+    });
+
+    FlockFrame* shown = nullptr;
+    while (window.isOpen())
+    {
+        sf::Event event;
+        while (window.pollEvent(event))
+        {
+            if (event.type == sf::Event::Closed)
+                window.close();
+        }
+
+        if (FlockFrame* fresh = pipeline.tryConsumeLatest())
+        {
+            if (shown)
+                pipeline.release(shown);
+            shown = fresh;
+        }
+
+        {
+            ProfileScope scope("draw");
+            window.clear(sf::Color::White);
+            if (shown)
+            {
+                shown->trails.draw(window);
+                boids.update(shown->previous, shown->current, shown->alpha, wrapJump);
+                boids.draw(window);
+            }
+        }
+        ProfileScope scope("display");
+        window.display();
+    }
+
+    pipeline.close();
+    simulationThread.join();
+    finishFlockDemo(demo, options);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,408 @@
+#ifndef FLOCK_SIMULATION_HPP
+#define FLOCK_SIMULATION_HPP
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+#include "flocking-wander.hpp"
+#include "JobSystem.hpp"
+#include "MortonOrder.hpp"
+#include "Profiler.hpp"
+#include "Snapshot.hpp"
+#include "SteeringLod.hpp"
+
+
+// Tunables shared by the flocking demos.
+struct FlockParams {
+    float neighborRadius     = 60.f;
+    float separationRadius   = 40.f;
+    float separationWeight   = 150.f;
+    float alignmentWeight    = 1.f;
+    float cohesionWeight     = 1.f;
+    float maxAccel           = 250.f;
+
+    float wanderMaxAccel     = 5.f;
+    float wanderMaxSpeed     = 7.f;
+    float wanderOffset       = 10.f;
+    float wanderRadius       = 15.f;
+    float wanderRate         = 1.f;
+    float wanderTimeToTarget = 0.1f;
+
+    float maxSpeed           = 13.f;
+    float worldWidth         = 640.f;
+    float worldHeight        = 480.f;
+
+    // Neighbor search; see SpatialGrid, NeighborList and FlockKernel.
+    bool useSpatialGrid      = true;
+    bool useNeighborList     = true;
+    float neighborSkin       = 10.f;
+    bool useSimdKernel       = true;
+    // Frames between re-sorts of the boids into Morton order; 0 never sorts.
+    int sortInterval         = 0;
+
+    // Off by default: every boid steers every frame.
+    SteeringLodParams lod;
+};
+
+// "name=value" lines, for files that record which parameters made them.
+inline std::string formatFlockParams(const FlockParams& params) {
+    std::string text;
+    auto add = [&text](const char* name, double value) {
+        char line[64];
+        std::snprintf(line, sizeof(line), "%s=%.9g\n", name, value);
+        text += line;
+    };
+    add("neighborRadius", params.neighborRadius);
+    add("separationRadius", params.separationRadius);
+    add("separationWeight", params.separationWeight);
+    add("alignmentWeight", params.alignmentWeight);
+    add("cohesionWeight", params.cohesionWeight);
+    add("maxAccel", params.maxAccel);
+    add("wanderMaxAccel", params.wanderMaxAccel);
+    add("wanderMaxSpeed", params.wanderMaxSpeed);
+    add("wanderOffset", params.wanderOffset);
+    add("wanderRadius", params.wanderRadius);
+    add("wanderRate", params.wanderRate);
+    add("wanderTimeToTarget", params.wanderTimeToTarget);
+    add("maxSpeed", params.maxSpeed);
+    add("worldWidth", params.worldWidth);
+    add("worldHeight", params.worldHeight);
+    add("useSpatialGrid", params.useSpatialGrid);
+    add("useNeighborList", params.useNeighborList);
+    add("neighborSkin", params.neighborSkin);
+    add("useSimdKernel", params.useSimdKernel);
+    add("sortInterval", params.sortInterval);
+    add("lod", params.lod.enabled);
+    add("lodIsolatedInterval", params.lod.isolatedInterval);
+    add("lodOffscreenInterval", params.lod.offscreenInterval);
+    add("lodBudget", params.lod.budget);
+    return text;
+}
+
+
+// Writes boid i of next from current and its steering: speed clamped to
+// maxSpeed, position wrapped around a width x height world, facing its
+// velocity.
+inline void integrateBoid(const FlockState& current, FlockState& next, std::size_t i,
+                          const SteeringOutput& steering, float deltaTime,
+                          float maxSpeed, float width, float height) {
+    sf::Vector2f velocity = current.velocity(i) + steering.linear * deltaTime;
+    velocity = clamp(velocity, maxSpeed);
+    next.setVelocity(i, velocity);
+    float x = current.x[i] + velocity.x * deltaTime;
+    float y = current.y[i] + velocity.y * deltaTime;
+
+    if (x < 0) x += width;
+    if (y < 0) y += height;
+    if (x > width) x -= width;
+    if (y > height) y -= height;
+    next.x[i] = x;
+    next.y[i] = y;
+
+    next.orientation[i] = current.orientation[i];
+    if (vectorLength(velocity) > 0)
+        next.orientation[i] = std::atan2(velocity.y, velocity.x);
+    next.rotation[i] = current.rotation[i];
+}
+
+
+// Steps a flock with double-buffered state: every boid's steering reads the
+// current frame and its integration writes the next one, so boids can be
+// updated in any order on any number of threads with identical results.
+//
+// A frame is a task graph: one neighbor-search task, then per chunk of boids
+// a steering task followed by an integration task. Chunks do not wait for
+// each other, and callers can hang their own per-chunk tasks off the
+// integration tasks (see schedule()).
+class FlockSimulation {
+public:
+    static const std::size_t chunkSize = 256;
+
+    struct FrameTasks {
+        TaskGraph::TaskId neighbors;
+        std::vector<TaskGraph::TaskId> integrated;  // one per chunk of chunkSize boids
+    };
+
+    FlockSimulation(const FlockParams& params, int threadCount = 0)
+        : params(params), jobs(threadCount),
+          grid(params.neighborRadius), neighborList(params.neighborRadius, params.neighborSkin),
+          lod(params.lod), frames(0)
+    {}
+
+    FlockSimulation(const FlockSimulation&) = delete;
+    FlockSimulation& operator=(const FlockSimulation&) = delete;
+
+    // The i-th boid added wanders on stream i of seed.
+    void addBoid(const Kinematic& k, unsigned seed) {
+        std::uint32_t id = static_cast<std::uint32_t>(ids.size());
+        current.push_back(k);
+        next.push_back(k);
+        steerings.push_back(SteeringOutput());
+        neighborCounts.push_back(0);
+        behaviors.push_back(makeBehavior());
+        behaviors.back().seedWander(seed, id);
+        ids.push_back(id);
+        slots.push_back(id);
+    }
+
+    // The flock, every boid's wander and random stream, the neighbor lists'
+    // build positions, the last steerings with the level-of-detail frame,
+    // and the order the boids are in: enough for load() to continue bit for
+    // bit.
+    // Parameters are not saved; load with the same ones.
+    void save(SnapshotWriter& out) const {
+        out.array(current.x);
+        out.array(current.y);
+        out.array(current.vx);
+        out.array(current.vy);
+        out.array(current.orientation);
+        out.array(current.rotation);
+        std::vector<float> wanderOrientation(size());
+        std::vector<std::uint32_t> streams(size()), seeds(size()), positions(size());
+        for (std::size_t i = 0; i < size(); ++i) {
+            WanderState wander = behaviors[i].getWanderState();
+            wanderOrientation[i] = wander.orientation;
+            streams[i] = wander.random.getStream();
+            seeds[i] = wander.random.getSeed();
+            positions[i] = wander.random.tell();
+        }
+        out.array(wanderOrientation);
+        out.array(streams);
+        out.array(seeds);
+        out.array(positions);
+        neighborList.save(out);
+        out.array(steerings);
+        out.array(neighborCounts);
+        lod.save(out);
+        out.array(ids);
+        out.value(frames);
+    }
+
+    // Into a simulation with no boids yet.
+    bool load(SnapshotReader& in) {
+        FlockState flock;
+        in.array(flock.x);
+        in.array(flock.y);
+        in.array(flock.vx);
+        in.array(flock.vy);
+        in.array(flock.orientation);
+        in.array(flock.rotation);
+        std::vector<float> wanderOrientation;
+        std::vector<std::uint32_t> streams, seeds, positions;
+        in.array(wanderOrientation);
+        in.array(streams);
+        in.array(seeds);
+        in.array(positions);
+        neighborList.load(in);
+        std::vector<SteeringOutput> lastSteerings;
+        std::vector<int> lastCounts;
+        in.array(lastSteerings);
+        in.array(lastCounts);
+        lod.load(in);
+        std::vector<std::uint32_t> savedIds;
+        in.array(savedIds);
+        in.value(frames);
+        std::size_t n = flock.x.size();
+        for (const std::size_t columnSize : { flock.y.size(), flock.vx.size(), flock.vy.size(),
+                                              flock.orientation.size(), flock.rotation.size(),
+                                              wanderOrientation.size(), streams.size(), seeds.size(),
+                                              positions.size(), lastSteerings.size(), lastCounts.size(),
+                                              savedIds.size() })
+            if (columnSize != n)
+                in.fail();
+        // Every spawn index exactly once.
+        std::vector<std::uint32_t> savedSlots(n, static_cast<std::uint32_t>(n));
+        for (std::size_t k = 0; k < savedIds.size() && in.ok(); ++k) {
+            if (savedIds[k] >= n || savedSlots[savedIds[k]] != n)
+                in.fail();
+            else
+                savedSlots[savedIds[k]] = static_cast<std::uint32_t>(k);
+        }
+        if (size() != 0 || (neighborList.size() != 0 && neighborList.size() != n))
+            in.fail();
+        if (!in.ok())
+            return false;
+
+        current.swap(flock);
+        next = current;
+        steerings.swap(lastSteerings);
+        neighborCounts.swap(lastCounts);
+        ids.swap(savedIds);
+        slots.swap(savedSlots);
+        behaviors.assign(n, makeBehavior());
+        for (std::size_t i = 0; i < n; ++i) {
+            RandomStream random(streams[i], seeds[i]);
+            random.seek(positions[i]);
+            behaviors[i].setWanderState(WanderState{ wanderOrientation[i], random });
+        }
+        return true;
+    }
+
+    void step(float deltaTime) {
+        TaskGraph graph;
+        schedule(graph, deltaTime);
+        jobs.run(graph);
+        commit();
+    }
+
+    // Adds this frame's tasks to graph. Once integrated[c] has run, boids of
+    // chunk c are final in stepped(). Run the graph, then call commit().
+    FrameTasks schedule(TaskGraph& graph, float deltaTime) {
+        FrameTasks tasks;
+        tasks.neighbors = graph.add([this] {
+            ProfileScope scope("neighbors");
+            if (params.useNeighborList)
+                neighborList.update(current.size(), current.positions());
+            else if (params.useSpatialGrid)
+                grid.rebuild(current.size(), current.positions());
+            if (lod.isEnabled())
+                lod.plan(current.size(), current.positions(),
+                         [this](std::size_t i) { return neighborCounts[i]; },
+                         [this](std::size_t i) { return ids[i]; });
+        });
+        for (std::size_t begin = 0; begin < current.size(); begin += chunkSize) {
+            std::size_t end = std::min(current.size(), begin + chunkSize);
+            TaskGraph::TaskId steer = graph.add([this, begin, end, deltaTime] {
+                ProfileScope scope("steer");
+                for (std::size_t i = begin; i < end; ++i) {
+                    // Between updates a boid keeps its last steering.
+                    if (!lod.isDue(i, ids[i]))
+                        continue;
+                    steerings[i] = behaviors[i].getSteering(i, deltaTime);
+                    neighborCounts[i] = behaviors[i].getNeighborCount();
+                }
+            });
+            TaskGraph::TaskId integrated = graph.add([this, begin, end, deltaTime] {
+                ProfileScope scope("integrate");
+                for (std::size_t i = begin; i < end; ++i)
+                    integrate(i, steerings[i], deltaTime);
+            });
+            graph.precede(tasks.neighbors, steer);
+            graph.precede(steer, integrated);
+            tasks.integrated.push_back(integrated);
+        }
+        return tasks;
+    }
+
+    // Makes the stepped frame current. Every sortInterval frames it then
+    // re-sorts the boids (see sortBoids()) and returns true.
+    bool commit() {
+        current.swap(next);
+        frames++;
+        if (params.sortInterval <= 0 || frames % static_cast<std::uint64_t>(params.sortInterval) != 0)
+            return false;
+        sortBoids();
+        return true;
+    }
+
+    // Reorders the boids along the Morton curve of their positions, so boids
+    // near each other in the world are near each other in memory and the
+    // neighbor loops touch fewer cache lines. Everything kept per boid moves
+    // with it: both frames, behaviors with their wander streams, steerings.
+    // Boid k is now the one that was at getOrder()[k]; callers move their
+    // own per-boid data the same way. The neighbor lists are rebuilt.
+    void sortBoids() {
+        ProfileScope scope("sort");
+        sorter.sort(size(), current.positions(), params.worldWidth, params.worldHeight, order);
+        sorted.gather(current, order);
+        current.swap(sorted);
+        sorted.gather(next, order);
+        next.swap(sorted);
+        permute(behaviors);
+        permute(steerings);
+        permute(neighborCounts);
+        permute(ids);
+        for (std::size_t k = 0; k < ids.size(); ++k)
+            slots[ids[k]] = static_cast<std::uint32_t>(k);
+        neighborList.invalidate();
+    }
+
+    // Permutation applied by the last sort.
+    const std::vector<std::uint32_t>& getOrder() const { return order; }
+    // Where each boid is now, by the order they were added in; the identity
+    // until the first sort.
+    const std::vector<std::uint32_t>& getSlots() const { return slots; }
+    bool isSorting() const { return params.sortInterval > 0; }
+
+    // What is on screen, for the steering level of detail; see SteeringLod.
+    void setView(const sf::FloatRect& view) { lod.setView(view); }
+    const SteeringLod& getLod() const { return lod; }
+
+    const FlockState& state() const { return current; }
+    const FlockState& stepped() const { return next; }
+    // Between commit() and the next step, the frame before state().
+    const FlockState& previous() const { return next; }
+    JobSystem& getJobs() { return jobs; }
+    std::size_t size() const { return current.size(); }
+    const FlockParams& getParams() const { return params; }
+    int getThreadCount() const { return jobs.getThreadCount(); }
+
+private:
+    FlockParams params;
+    JobSystem jobs;
+    FlockState current;  // read by every boid's steering
+    FlockState next;     // written by integration, swapped in after the step
+    std::vector<FlockingBehavior> behaviors;
+    std::vector<SteeringOutput> steerings;
+    std::vector<int> neighborCounts;  // from each boid's last steering update
+    SpatialGrid grid;
+    NeighborList neighborList;
+    SteeringLod lod;
+    std::vector<std::uint32_t> ids;    // order added of the boid in each slot
+    std::vector<std::uint32_t> slots;  // inverse of ids
+    std::vector<std::uint32_t> order;  // last sort's permutation
+    // Kept between sorts so re-sorting allocates nothing.
+    MortonSorter sorter;
+    FlockState sorted;
+    std::vector<char> placed;
+    std::uint64_t frames;              // committed steps, for the sort interval
+
+    template <typename T>
+    void permute(std::vector<T>& values) {
+        // In place, one cycle of the permutation at a time: a copy of
+        // behaviors alone would be as large as the rest of the flock.
+        placed.assign(values.size(), 0);
+        for (std::size_t k = 0; k < values.size(); ++k) {
+            if (placed[k])
+                continue;
+            T first = std::move(values[k]);
+            std::size_t to = k;
+            for (std::size_t from = order[k]; from != k; from = order[from]) {
+                values[to] = std::move(values[from]);
+                placed[to] = 1;
+                to = from;
+            }
+            values[to] = std::move(first);
+            placed[to] = 1;
+        }
+    }
+
+    FlockingBehavior makeBehavior() {
+        FlockingBehavior behavior(&current,
+                                  params.neighborRadius, params.separationRadius,
+                                  params.separationWeight, params.alignmentWeight, params.cohesionWeight,
+                                  params.maxAccel,
+                                  params.wanderMaxAccel, params.wanderMaxSpeed, params.wanderOffset,
+                                  params.wanderRadius, params.wanderRate, params.wanderTimeToTarget);
+        if (params.useNeighborList)
+            behavior.setNeighborList(&neighborList);
+        else if (params.useSpatialGrid)
+            behavior.setNeighborGrid(&grid);
+        if (params.useSimdKernel)
+            behavior.setSimdLevel(detectSimdLevel());
+        return behavior;
+    }
+
+    void integrate(std::size_t i, const SteeringOutput& steering, float deltaTime) {
+        integrateBoid(current, next, i, steering, deltaTime, params.maxSpeed,
+                      params.worldWidth, params.worldHeight);
+    }
+};
+
+#endif
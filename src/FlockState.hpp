@@ -0,0 +1,103 @@
+#ifndef FLOCK_STATE_HPP
+#define FLOCK_STATE_HPP
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Steering.hpp"
+
+
+// What drawing a flock needs: count positions and orientations as columns.
+// The columns may live in a FlockState or in a mapped trajectory file.
+struct FlockColumns {
+    const float* x;
+    const float* y;
+    const float* orientation;
+    std::size_t count;
+};
+
+
+// Struct-of-arrays storage for a flock. The neighbor loop only touches
+// x/y/vx/vy, so orientation and rotation stay out of its cache lines.
+struct FlockState {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> vx;
+    std::vector<float> vy;
+    std::vector<float> orientation;
+    std::vector<float> rotation;
+
+    std::size_t size() const { return x.size(); }
+
+    void resize(std::size_t n) {
+        x.resize(n);
+        y.resize(n);
+        vx.resize(n);
+        vy.resize(n);
+        orientation.resize(n);
+        rotation.resize(n);
+    }
+
+    void push_back(const Kinematic& k) {
+        resize(size() + 1);
+        set(size() - 1, k);
+    }
+
+    void swap(FlockState& other) {
+        x.swap(other.x);
+        y.swap(other.y);
+        vx.swap(other.vx);
+        vy.swap(other.vy);
+        orientation.swap(other.orientation);
+        rotation.swap(other.rotation);
+    }
+
+    // Agent k becomes from's agent order[k]; from must be another state.
+    void gather(const FlockState& from, const std::vector<std::uint32_t>& order) {
+        resize(order.size());
+        for (std::size_t k = 0; k < order.size(); ++k) {
+            std::uint32_t i = order[k];
+            x[k] = from.x[i];
+            y[k] = from.y[i];
+            vx[k] = from.vx[i];
+            vy[k] = from.vy[i];
+            orientation[k] = from.orientation[i];
+            rotation[k] = from.rotation[i];
+        }
+    }
+
+    sf::Vector2f position(std::size_t i) const { return sf::Vector2f(x[i], y[i]); }
+    sf::Vector2f velocity(std::size_t i) const { return sf::Vector2f(vx[i], vy[i]); }
+
+    void setPosition(std::size_t i, const sf::Vector2f& p) { x[i] = p.x; y[i] = p.y; }
+    void setVelocity(std::size_t i, const sf::Vector2f& v) { vx[i] = v.x; vy[i] = v.y; }
+
+    // Kinematic view of agent i, for behaviors written against Kinematic.
+    Kinematic get(std::size_t i) const {
+        Kinematic k;
+        k.position = position(i);
+        k.velocity = velocity(i);
+        k.orientation = orientation[i];
+        k.rotation = rotation[i];
+        return k;
+    }
+
+    void set(std::size_t i, const Kinematic& k) {
+        setPosition(i, k.position);
+        setVelocity(i, k.velocity);
+        orientation[i] = k.orientation;
+        rotation[i] = k.rotation;
+    }
+
+    FlockColumns columns() const {
+        return FlockColumns{ x.data(), y.data(), orientation.data(), size() };
+    }
+
+    // Position accessor for SpatialGrid::rebuild and NeighborList::update.
+    auto positions() const {
+        return [this](std::size_t i) { return position(i); };
+    }
+};
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef FRAME_PIPELINE_HPP
+#define FRAME_PIPELINE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+
+// Bounded hand-off of frames from a producer (simulation) thread to a
+// consumer (render) thread. A fixed set of depth buffers cycles between a
+// free list and a ready queue, so nothing is allocated per frame. The
+// producer blocks when every buffer is in use; a render consumer uses
+// tryConsumeLatest() and keeps the frame it has when nothing new is ready,
+// a writer consumer, which needs every frame, blocks in consume().
+template <typename Frame>
+class FramePipeline {
+public:
+    explicit FramePipeline(std::size_t depth = 3)
+        : frames(depth), closed(false)
+    {
+        for (auto& frame : frames)
+            freeFrames.push_back(&frame);
+    }
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    // Producer: a buffer to fill, or nullptr once the pipeline is closed.
+    Frame* acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        freed.wait(lock, [this] { return closed || !freeFrames.empty(); });
+        if (closed)
+            return nullptr;
+        Frame* frame = freeFrames.front();
+        freeFrames.pop_front();
+        return frame;
+    }
+
+    void publish(Frame* frame) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            readyFrames.push_back(frame);
+        }
+        ready.notify_one();
+    }
+
+    // Consumer: the newest finished frame, or nullptr if none is ready.
+    // Older ready frames are stale for drawing and go straight back to the
+    // producer, so a fast producer cannot queue up lag behind the display.
+    Frame* tryConsumeLatest() {
+        Frame* frame = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (readyFrames.empty())
+                return nullptr;
+            frame = readyFrames.back();
+            readyFrames.pop_back();
+            freeFrames.insert(freeFrames.end(), readyFrames.begin(), readyFrames.end());
+            readyFrames.clear();
+        }
+        freed.notify_all();
+        return frame;
+    }
+
+    // Consumer: blocks until a frame is ready. Frames published before
+    // close() are still handed out; nullptr once closed and drained.
+    Frame* consume() {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return closed || !readyFrames.empty(); });
+        if (readyFrames.empty())
+            return nullptr;
+        Frame* frame = readyFrames.front();
+        readyFrames.pop_front();
+        return frame;
+    }
+
+    // Consumer: hands a frame it is done drawing back to the producer.
+    void release(Frame* frame) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            freeFrames.push_back(frame);
+        }
+        freed.notify_one();
+    }
+
+    // Wakes a producer blocked in acquire() or a consumer blocked in
+    // consume() so it can exit.
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        freed.notify_all();
+        ready.notify_all();
+    }
+
+private:
+    std::vector<Frame> frames;
+    std::deque<Frame*> freeFrames;
+    std::deque<Frame*> readyFrames;
+    std::mutex mutex;
+    std::condition_variable freed;
+    std::condition_variable ready;
+    bool closed;
+};
+
+#endif
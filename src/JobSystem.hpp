@@ -0,0 +1,206 @@
+#ifndef JOB_SYSTEM_HPP
+#define JOB_SYSTEM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// A set of tasks with dependencies, built once per frame and handed to
+// JobSystem::run. A task starts once every task that precedes it is done.
+class TaskGraph {
+public:
+    typedef std::size_t TaskId;
+
+    TaskId add(std::function<void()> fn) {
+        nodes.push_back(std::unique_ptr<Node>(new Node()));
+        nodes.back()->fn = std::move(fn);
+        return nodes.size() - 1;
+    }
+
+    // after will not start before before has finished.
+    void precede(TaskId before, TaskId after) {
+        nodes[before]->successors.push_back(nodes[after].get());
+        nodes[after]->predecessors++;
+    }
+
+    // One task per chunk of at most grain items of [0, count); fn(begin, end).
+    std::vector<TaskId> addChunked(std::size_t count, std::size_t grain,
+                                   const std::function<void(std::size_t, std::size_t)>& fn) {
+        grain = std::max<std::size_t>(1, grain);
+        std::vector<TaskId> ids;
+        for (std::size_t begin = 0; begin < count; begin += grain) {
+            std::size_t end = std::min(count, begin + grain);
+            ids.push_back(add([fn, begin, end] { fn(begin, end); }));
+        }
+        return ids;
+    }
+
+    std::size_t size() const { return nodes.size(); }
+    void clear() { nodes.clear(); }
+
+private:
+    friend class JobSystem;
+
+    struct Node {
+        std::function<void()> fn;
+        std::vector<Node*> successors;
+        int predecessors = 0;
+        std::atomic<int> waiting{0};
+    };
+
+    std::vector<std::unique_ptr<Node>> nodes;
+};
+
+
+// Work-stealing scheduler. Every thread has its own deque: it pushes and
+// pops newly ready tasks at the back (most recent first, still warm in
+// cache) and idle threads steal from the front of the others. The thread
+// calling run() is worker 0 and works until the graph is finished.
+class JobSystem {
+public:
+    // threadCount <= 0 uses every hardware thread.
+    explicit JobSystem(int threadCount = 0)
+        : stopping(false), queued(0), remaining(0)
+    {
+        if (threadCount <= 0)
+            threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        for (int i = 0; i < threadCount; ++i)
+            queues.push_back(std::unique_ptr<Queue>(new Queue()));
+        for (int i = 1; i < threadCount; ++i)
+            threads.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    ~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    int getThreadCount() const { return static_cast<int>(queues.size()); }
+
+    // Runs every task in graph and returns when all of them are done.
+    void run(TaskGraph& graph) {
+        if (graph.nodes.empty())
+            return;
+        remaining.store(static_cast<int>(graph.nodes.size()));
+        for (auto& node : graph.nodes)
+            node->waiting.store(node->predecessors);
+        for (auto& node : graph.nodes)
+            if (node->predecessors == 0)
+                push(0, node.get());
+
+        while (remaining.load() > 0) {
+            TaskGraph::Node* node = take(0);
+            if (node) {
+                execute(0, node);
+            } else {
+                std::unique_lock<std::mutex> lock(sleepMutex);
+                wake.wait(lock, [this] { return queued.load() > 0 || remaining.load() == 0; });
+            }
+        }
+    }
+
+    // Convenience for a single data-parallel loop with no dependencies.
+    void parallelFor(std::size_t count, std::size_t grain,
+                     const std::function<void(std::size_t, std::size_t)>& fn) {
+        if (queues.size() == 1 || count <= grain) {
+            if (count > 0)
+                fn(0, count);
+            return;
+        }
+        TaskGraph graph;
+        graph.addChunked(count, grain, fn);
+        run(graph);
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<TaskGraph::Node*> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping;
+    std::atomic<int> queued;     // tasks sitting in some deque
+    std::atomic<int> remaining;  // tasks of the current graph not yet finished
+
+    void push(int worker, TaskGraph::Node* node) {
+        {
+            std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+            queues[worker]->tasks.push_back(node);
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            queued++;
+        }
+        wake.notify_one();
+    }
+
+    TaskGraph::Node* take(int worker) {
+        TaskGraph::Node* node = nullptr;
+        {
+            Queue& own = *queues[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                node = own.tasks.back();
+                own.tasks.pop_back();
+            }
+        }
+        for (std::size_t k = 1; !node && k < queues.size(); ++k) {
+            Queue& victim = *queues[(worker + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                node = victim.tasks.front();
+                victim.tasks.pop_front();
+            }
+        }
+        if (node)
+            queued--;
+        return node;
+    }
+
+    void execute(int worker, TaskGraph::Node* node) {
+        node->fn();
+        for (TaskGraph::Node* next : node->successors)
+            if (next->waiting.fetch_sub(1) == 1)
+                push(worker, next);
+        if (remaining.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            wake.notify_all();
+        }
+    }
+
+    void workerLoop(int worker) {
+        for (;;) {
+            TaskGraph::Node* node = take(worker);
+            if (node) {
+                execute(worker, node);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+            if (stopping)
+                return;
+        }
+    }
+};
+
+#endif
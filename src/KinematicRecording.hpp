@@ -0,0 +1,62 @@
+#ifndef KINEMATIC_RECORDING_HPP
+#define KINEMATIC_RECORDING_HPP
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include "DemoOptions.hpp"
+#include "FlockState.hpp"
+#include "TrajectoryRecorder.hpp"
+
+
+// --record for the wander demos (part3a, part3b, main), whose boids each
+// keep their own Kinematic instead of living in a FlockState. Every frame
+// is copied into one reused FlockState and handed to a TrajectoryRecorder,
+// so the file plays back with --replay like a flocking demo's. Without
+// --record every call does nothing.
+class KinematicRecording {
+public:
+    KinematicRecording(const DemoOptions& options, std::size_t agents, float dt, unsigned seed,
+                       const std::string& params, sf::Vector2u worldSize)
+        : path(options.record)
+    {
+        if (!path)
+            return;
+        TrajectoryHeader header = TrajectoryHeader::make(agents, dt, seed, params);
+        header.worldWidth = static_cast<float>(worldSize.x);
+        header.worldHeight = static_cast<float>(worldSize.y);
+        TrajectoryRecorder::Options recording;
+        recording.velocityDeltas = options.recordDeltas;
+        recorder.reset(new TrajectoryRecorder(path, header, recording));
+        if (!recorder->isOpen()) {
+            std::fprintf(stderr, "cannot write trajectory to '%s'\n", path);
+            recorder.reset();
+        }
+        frame.resize(agents);
+    }
+
+    // Records one frame; kinematic(i) is agent i's current state.
+    template <typename KinematicFn>
+    void record(KinematicFn kinematic) {
+        if (!recorder)
+            return;
+        for (std::size_t i = 0; i < frame.size(); ++i)
+            frame.set(i, kinematic(i));
+        recorder->record(frame);
+    }
+
+    // The headless summary line; stepSeconds includes the time in record().
+    void report(double stepSeconds) const {
+        if (recorder)
+            reportRecording(*recorder, path, stepSeconds - recorder->getRecordSeconds());
+    }
+
+private:
+    const char* path;
+    std::unique_ptr<TrajectoryRecorder> recorder;
+    FlockState frame;
+};
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef MICRO_BENCH_HPP
+#define MICRO_BENCH_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define MICRO_BENCH_RDTSC 1
+#endif
+
+// Tiny microbenchmark harness for the bench_* binaries. It replaces the
+// global operator new to count allocations, so include it from exactly one
+// translation unit (every binary in this repo is a single .cpp).
+
+inline std::atomic<std::size_t>& allocationCounter() {
+    static std::atomic<std::size_t> count(0);
+    return count;
+}
+
+// TSC ticks on x86; elsewhere there is no portable cycle counter and the
+// cycles column falls back to nanoseconds.
+inline std::uint64_t readCycles() {
+#ifdef MICRO_BENCH_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Keeps the compiler from seeing which object a pointer refers to, so calls
+// through it really go through the vtable.
+template<typename T>
+inline T* opaque(T* pointer) {
+    asm volatile("" : "+r"(pointer));
+    return pointer;
+}
+
+struct BenchResult {
+    const char* name;
+    double callsPerSecond;
+    double nsPerCall;
+    double cyclesPerCall;
+    double allocationsPerCall;
+};
+
+// fn(i) makes call i and returns something derived from its output, which
+// is summed and handed to an empty asm so the call cannot be optimised away.
+template<typename Fn>
+BenchResult measureCalls(const char* name, std::size_t calls, Fn fn) {
+    float sum = 0.f;
+    for (std::size_t i = 0; i < calls / 16; ++i)
+        sum += fn(i);
+
+    std::size_t allocations = allocationCounter().load();
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t cycles = readCycles();
+    for (std::size_t i = 0; i < calls; ++i)
+        sum += fn(i);
+    cycles = readCycles() - cycles;
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    allocations = allocationCounter().load() - allocations;
+    asm volatile("" : : "r"(sum));
+
+    BenchResult result;
+    result.name = name;
+    result.callsPerSecond = calls / (ns * 1e-9);
+    result.nsPerCall = ns / calls;
+    result.cyclesPerCall = static_cast<double>(cycles) / calls;
+    result.allocationsPerCall = static_cast<double>(allocations) / calls;
+    return result;
+}
+
+inline void printBenchHeader() {
+    std::printf("%-40s %14s %10s %12s %12s\n", "case", "calls/sec", "ns/call", "cycles/call", "allocs/call");
+}
+
+inline void printBenchResult(const BenchResult& r) {
+    std::printf("%-40s %14.0f %10.2f %12.2f %12.3f\n",
+                r.name, r.callsPerSecond, r.nsPerCall, r.cyclesPerCall, r.allocationsPerCall);
+}
+
+// Random character/target pairs; works for either Kinematic (Steering.hpp
+// and VelocityMatching.hpp order the fields differently).
+template<typename K>
+std::vector<K> randomKinematics(std::size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> position(0.f, 640.f);
+    std::uniform_real_distribution<float> velocity(-20.f, 20.f);
+    std::uniform_real_distribution<float> angle(-3.14159f, 3.14159f);
+    std::vector<K> out(count);
+    for (K& k : out) {
+        k.position.x = position(rng);
+        k.position.y = position(rng);
+        k.velocity.x = velocity(rng);
+        k.velocity.y = velocity(rng);
+        k.orientation = angle(rng);
+        k.rotation = angle(rng);
+    }
+    return out;
+}
+
+void* operator new(std::size_t size) {
+    allocationCounter()++;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+// noinline keeps GCC from pairing the inlined free() with the builtin new
+// and warning about a mismatch.
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+#endif
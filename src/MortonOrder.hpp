@@ -0,0 +1,71 @@
+#ifndef MORTON_ORDER_HPP
+#define MORTON_ORDER_HPP
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// Interleaves the bits of x and y (x in the even bits): the Z-order curve,
+// along which points close in the plane are mostly close in the order.
+inline std::uint32_t mortonCode(std::uint16_t x, std::uint16_t y) {
+    auto spread = [](std::uint32_t v) {
+        v = (v | (v << 8)) & 0x00ff00ffu;
+        v = (v | (v << 4)) & 0x0f0f0f0fu;
+        v = (v | (v << 2)) & 0x33333333u;
+        v = (v | (v << 1)) & 0x55555555u;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
+// Sorts agents by the Morton code of their position, quantized to 16 bits
+// per axis over a width x height world. Agents with equal codes keep their
+// relative order (the sort is an LSD radix sort), so the same positions
+// always give the same permutation. The code and scratch buffers are kept
+// between sorts, so re-sorting the same number of agents allocates nothing.
+class MortonSorter {
+public:
+    // Fills order with the indices of count agents in Morton order.
+    template <typename PositionFn>
+    void sort(std::size_t count, PositionFn position, float width, float height,
+              std::vector<std::uint32_t>& order) {
+        codes.resize(count);
+        sortedCodes.resize(count);
+        scratch.resize(count);
+        order.resize(count);
+        const float sx = width > 0.f ? 65535.f / width : 0.f;
+        const float sy = height > 0.f ? 65535.f / height : 0.f;
+        for (std::size_t i = 0; i < count; ++i) {
+            sf::Vector2f p = position(i);
+            float qx = std::max(0.f, std::min(65535.f, p.x * sx));
+            float qy = std::max(0.f, std::min(65535.f, p.y * sy));
+            codes[i] = mortonCode(static_cast<std::uint16_t>(qx), static_cast<std::uint16_t>(qy));
+            order[i] = static_cast<std::uint32_t>(i);
+        }
+
+        // Four stable counting passes, 8 bits each, least significant first;
+        // an even number of swaps leaves the result in order's own buffer.
+        for (int shift = 0; shift < 32; shift += 8) {
+            std::size_t start[257] = {};
+            for (std::size_t i = 0; i < count; ++i)
+                start[((codes[i] >> shift) & 0xffu) + 1]++;
+            for (int b = 1; b <= 256; ++b)
+                start[b] += start[b - 1];
+            for (std::size_t i = 0; i < count; ++i) {
+                std::size_t slot = start[(codes[i] >> shift) & 0xffu]++;
+                scratch[slot] = order[i];
+                sortedCodes[slot] = codes[i];
+            }
+            order.swap(scratch);
+            codes.swap(sortedCodes);
+        }
+    }
+
+private:
+    std::vector<std::uint32_t> codes, sortedCodes, scratch;
+};
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef NEIGHBOR_LIST_HPP
+#define NEIGHBOR_LIST_HPP
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <vector>
+#include "Snapshot.hpp"
+#include "SpatialGrid.hpp"
+
+
+// Verlet neighbor lists: for every agent, the indices of the agents within
+// radius + skin at the last build. While no agent has moved more than skin/2
+// since then, every pair closer than radius is guaranteed to be in the lists,
+// so they can be reused across frames. Lists are kept in ascending order.
+class NeighborList {
+public:
+    NeighborList(float radius, float skin)
+        : radius(radius), skin(skin), grid(radius + skin), rebuilds(0)
+    {}
+
+    template <typename Agents>
+    bool update(const Agents& agents) {
+        return update(agents.size(), [&](std::size_t i) { return agents[i].position; });
+    }
+
+    // Rebuilds the lists if some agent has moved more than skin/2 since the
+    // last build (or the agent count changed). Returns true if it rebuilt.
+    template <typename PositionFn>
+    bool update(std::size_t count, PositionFn position) {
+        if (needsRebuild(count, position)) {
+            rebuild(count, position);
+            return true;
+        }
+        return false;
+    }
+
+    template <typename PositionFn>
+    void rebuild(std::size_t count, PositionFn position) {
+        const float range = radius + skin;
+        grid.rebuild(count, position);
+        reference.resize(count);
+        offsets.assign(1, 0);
+        neighbors.clear();
+        for (std::size_t i = 0; i < count; ++i) {
+            sf::Vector2f p = position(i);
+            reference[i] = p;
+            grid.query(p, range, candidates);
+            for (int j : candidates) {
+                if (j == static_cast<int>(i))
+                    continue;
+                sf::Vector2f d = position(j) - p;
+                if (d.x * d.x + d.y * d.y < range * range)
+                    neighbors.push_back(j);
+            }
+            offsets.push_back(static_cast<int>(neighbors.size()));
+        }
+        rebuilds++;
+    }
+
+    // Forces a rebuild on the next update(), e.g. after the agents have been
+    // reordered and the stored indices no longer name the same agents.
+    void invalidate() {
+        reference.clear();
+        offsets.assign(1, 0);
+        neighbors.clear();
+    }
+
+    // The lists and the positions they were built at, so a restored
+    // simulation reuses exactly the lists it had (a fresh build could order
+    // the SIMD kernel's sums differently).
+    void save(SnapshotWriter& out) const {
+        out.array(reference);
+        out.array(offsets);
+        out.array(neighbors);
+    }
+
+    bool load(SnapshotReader& in) {
+        in.array(reference);
+        in.array(offsets);
+        in.array(neighbors);
+        if (offsets.size() != reference.size() + 1 ||
+            static_cast<std::size_t>(offsets.back()) != neighbors.size())
+            in.fail();
+        rebuilds = in.ok() && !reference.empty() ? 1 : 0;
+        return in.ok();
+    }
+
+    std::size_t size() const { return reference.size(); }
+    const int* begin(std::size_t i) const { return neighbors.data() + offsets[i]; }
+    const int* end(std::size_t i) const { return neighbors.data() + offsets[i + 1]; }
+
+    float getRadius() const { return radius; }
+    float getSkin() const { return skin; }
+    int getRebuildCount() const { return rebuilds; }
+
+private:
+    float radius;
+    float skin;
+    SpatialGrid grid;
+    int rebuilds;
+    std::vector<sf::Vector2f> reference;  // positions at the last build
+    std::vector<int> offsets;             // start of each agent's list, plus an end marker
+    std::vector<int> neighbors;
+    std::vector<int> candidates;
+
+    template <typename PositionFn>
+    bool needsRebuild(std::size_t count, PositionFn position) const {
+        if (count != reference.size() || rebuilds == 0)
+            return true;
+        const float limit = 0.25f * skin * skin;  // (skin / 2)^2
+        for (std::size_t i = 0; i < count; ++i) {
+            sf::Vector2f d = position(i) - reference[i];
+            if (d.x * d.x + d.y * d.y > limit)
+                return true;
+        }
+        return false;
+    }
+};
+
+#endif
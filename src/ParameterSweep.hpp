@@ -0,0 +1,109 @@
+#ifndef PARAMETER_SWEEP_HPP
+#define PARAMETER_SWEEP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "JobSystem.hpp"
+
+
+// One swept parameter: an explicit list "name=a,b,c", or a range
+// "name=low:high:count" that a grid covers with count evenly spaced values
+// (2 if count is left out) and a random sample draws from uniformly.
+struct SweepAxis {
+    std::string name;
+    std::vector<float> values;
+    bool range = false;
+    float low = 0.f;
+    float high = 0.f;
+};
+
+inline bool parseSweepAxis(const char* spec, SweepAxis& axis) {
+    const char* equals = std::strchr(spec, '=');
+    if (!equals || equals == spec)
+        return false;
+    axis = SweepAxis();
+    axis.name.assign(spec, equals);
+    std::string text(equals + 1);
+    if (std::count(text.begin(), text.end(), ':') > 0) {
+        float low, high;
+        int count = 2;
+        int fields = std::sscanf(text.c_str(), "%f:%f:%d", &low, &high, &count);
+        if (fields < 2 || count < 1)
+            return false;
+        axis.range = true;
+        axis.low = low;
+        axis.high = high;
+        for (int i = 0; i < count; ++i)
+            axis.values.push_back(count == 1 ? low : low + (high - low) * i / (count - 1));
+        return true;
+    }
+    for (const char* p = text.c_str(); *p; ) {
+        char* end;
+        float value = std::strtof(p, &end);
+        if (end == p)
+            return false;
+        axis.values.push_back(value);
+        p = (*end == ',') ? end + 1 : end;
+        if (*end && *end != ',')
+            return false;
+    }
+    return !axis.values.empty();
+}
+
+// A parameter set: one value per axis, in axis order.
+typedef std::vector<float> SweepPoint;
+
+// Every combination of the axes' values; the last axis varies fastest.
+inline std::vector<SweepPoint> sweepGrid(const std::vector<SweepAxis>& axes) {
+    std::vector<SweepPoint> points(1);
+    for (const SweepAxis& axis : axes) {
+        std::vector<SweepPoint> grown;
+        grown.reserve(points.size() * axis.values.size());
+        for (const SweepPoint& point : points)
+            for (float value : axis.values) {
+                grown.push_back(point);
+                grown.back().push_back(value);
+            }
+        points.swap(grown);
+    }
+    return points;
+}
+
+// count parameter sets: uniform within each range axis, one of the listed
+// values for the others.
+inline std::vector<SweepPoint> sweepRandom(const std::vector<SweepAxis>& axes, std::size_t count,
+                                           unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<SweepPoint> points(count);
+    for (SweepPoint& point : points)
+        for (const SweepAxis& axis : axes) {
+            if (axis.range) {
+                point.push_back(std::uniform_real_distribution<float>(axis.low, axis.high)(rng));
+            } else {
+                std::uniform_int_distribution<std::size_t> pick(0, axis.values.size() - 1);
+                point.push_back(axis.values[pick(rng)]);
+            }
+        }
+    return points;
+}
+
+// Calls run(index, point) for every point, one task per run spread over
+// threads (<= 0: every hardware thread). Runs must not share mutable state.
+template <typename Result, typename RunFn>
+std::vector<Result> runSweep(const std::vector<SweepPoint>& points, int threads, RunFn run) {
+    std::vector<Result> results(points.size());
+    JobSystem jobs(threads);
+    jobs.parallelFor(points.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+            results[i] = run(i, points[i]);
+    });
+    return results;
+}
+
+#endif
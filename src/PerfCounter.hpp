@@ -0,0 +1,79 @@
+#ifndef PERF_COUNTER_HPP
+#define PERF_COUNTER_HPP
+
+#include <cstdint>
+#include <cstring>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PERF_COUNTER_LINUX 1
+#endif
+
+// One hardware event counted through perf_event_open, for the calling thread
+// and every thread it starts after the counter is created (create it before
+// the JobSystem). Where the kernel, a VM or perf_event_paranoid does not
+// allow it, isAvailable() is false and stop() returns 0, so benchmarks can
+// print n/a instead.
+class PerfCounter {
+public:
+    enum Event { CacheMisses, CacheReferences };
+
+    explicit PerfCounter(Event event) : fd(-1) {
+#ifdef PERF_COUNTER_LINUX
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = event == CacheMisses ? PERF_COUNT_HW_CACHE_MISSES : PERF_COUNT_HW_CACHE_REFERENCES;
+        attr.disabled = 1;
+        attr.inherit = 1;  // count threads the process starts afterwards
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        (void)event;
+#endif
+    }
+
+    ~PerfCounter() {
+#ifdef PERF_COUNTER_LINUX
+        if (fd >= 0)
+            ::close(fd);
+#endif
+    }
+
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+
+    bool isAvailable() const { return fd >= 0; }
+
+    // Zeroes the count and starts counting.
+    void start() {
+#ifdef PERF_COUNTER_LINUX
+        if (fd >= 0) {
+            ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    // Stops counting and returns the count since start().
+    std::uint64_t stop() {
+        std::uint64_t count = 0;
+#ifdef PERF_COUNTER_LINUX
+        if (fd >= 0) {
+            ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (::read(fd, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count)))
+                count = 0;
+        }
+#endif
+        return count;
+    }
+
+private:
+    int fd;
+};
+
+#endif
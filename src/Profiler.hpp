@@ -0,0 +1,184 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+// Per-phase wall-clock profiler. Code marks a phase with a ProfileScope;
+// every scope that ends while the profiler is enabled becomes one event in
+// a per-thread log, so recording takes no lock. While disabled a scope
+// costs one relaxed atomic load, and building with -DFLOCK_PROFILER_OFF
+// removes even that.
+//
+// The logs are read by writeChromeTrace() and printSummary(), which must
+// only run once no thread is recording any more (e.g. at exit).
+class Profiler {
+public:
+    static Profiler& instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    static bool enabled() {
+#ifdef FLOCK_PROFILER_OFF
+        return false;
+#else
+        return instance().on.load(std::memory_order_relaxed);
+#endif
+    }
+
+    static std::uint64_t nowNs() {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void enable() {
+        on.store(true);
+    }
+
+    void disable() {
+        on.store(false);
+    }
+
+    // name must outlive the profiler (a string literal).
+    void record(const char* name, std::uint64_t startNs, std::uint64_t endNs) {
+        threadLog().events.push_back(Event{name, startNs, endNs - startNs});
+    }
+
+    // Chrome trace_event format ("X" events, microseconds); open it in
+    // chrome://tracing or Perfetto.
+    bool writeChromeTrace(const char* path) const {
+        std::FILE* file = std::fopen(path, "w");
+        if (!file)
+            return false;
+        std::fprintf(file, "{\"traceEvents\": [\n");
+        bool first = true;
+        for (const auto& log : logs) {
+            for (const Event& e : log->events) {
+                std::fprintf(file, "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                             "\"ts\": %.3f, \"dur\": %.3f}",
+                             first ? "" : ",\n", e.name, log->thread,
+                             (e.start - origin) / 1000.0, e.duration / 1000.0);
+                first = false;
+            }
+        }
+        std::fprintf(file, "\n], \"displayTimeUnit\": \"ms\"}\n");
+        return std::fclose(file) == 0;
+    }
+
+    // Count, total and p50/p95/p99 of every phase, over all threads.
+    void printSummary(std::FILE* out) const {
+        std::map<std::string, std::vector<std::uint64_t>> phases;
+        for (const auto& log : logs)
+            for (const Event& e : log->events)
+                phases[e.name].push_back(e.duration);
+        std::fprintf(out, "%-12s %8s %10s %10s %10s %10s\n",
+                     "phase", "count", "total ms", "p50 us", "p95 us", "p99 us");
+        for (auto& phase : phases) {
+            std::vector<std::uint64_t>& d = phase.second;
+            std::sort(d.begin(), d.end());
+            double total = 0.0;
+            for (std::uint64_t ns : d)
+                total += ns;
+            std::fprintf(out, "%-12s %8zu %10.2f %10.2f %10.2f %10.2f\n",
+                         phase.first.c_str(), d.size(), total / 1e6,
+                         percentile(d, 0.50) / 1e3, percentile(d, 0.95) / 1e3, percentile(d, 0.99) / 1e3);
+        }
+    }
+
+private:
+    struct Event {
+        const char* name;
+        std::uint64_t start;
+        std::uint64_t duration;
+    };
+
+    struct ThreadLog {
+        int thread;
+        std::vector<Event> events;
+    };
+
+    std::atomic<bool> on;
+    std::uint64_t origin;
+    std::mutex mutex;  // guards logs while threads register
+    std::vector<std::unique_ptr<ThreadLog>> logs;
+
+    Profiler() : on(false), origin(nowNs()) {}
+
+    ThreadLog& threadLog() {
+        thread_local ThreadLog* mine = nullptr;
+        if (!mine) {
+            std::lock_guard<std::mutex> lock(mutex);
+            logs.push_back(std::unique_ptr<ThreadLog>(new ThreadLog()));
+            mine = logs.back().get();
+            mine->thread = static_cast<int>(logs.size());
+        }
+        return *mine;
+    }
+
+    // Nearest-rank percentile of sorted values.
+    static double percentile(const std::vector<std::uint64_t>& sorted, double p) {
+        std::size_t rank = static_cast<std::size_t>(p * sorted.size());
+        return static_cast<double>(sorted[std::min(rank, sorted.size() - 1)]);
+    }
+};
+
+
+// Times the enclosing block as one event of the named phase.
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name)
+        : name(name), active(Profiler::enabled()), start(active ? Profiler::nowNs() : 0)
+    {}
+
+    ~ProfileScope() {
+        if (active)
+            Profiler::instance().record(name, start, Profiler::nowNs());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    bool active;
+    std::uint64_t start;
+};
+
+
+// Enables the profiler for its lifetime when given a path; on destruction
+// writes the Chrome trace there and prints the phase percentiles to stderr.
+class ProfileReport {
+public:
+    explicit ProfileReport(const char* tracePath) : path(tracePath) {
+        if (path)
+            Profiler::instance().enable();
+    }
+
+    ~ProfileReport() {
+        if (!path)
+            return;
+        Profiler& profiler = Profiler::instance();
+        profiler.disable();
+        if (!profiler.writeChromeTrace(path))
+            std::fprintf(stderr, "could not write profile trace '%s'\n", path);
+        profiler.printSummary(stderr);
+    }
+
+    ProfileReport(const ProfileReport&) = delete;
+    ProfileReport& operator=(const ProfileReport&) = delete;
+
+private:
+    const char* path;
+};
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef REPLAY_DEMO_HPP
+#define REPLAY_DEMO_HPP
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include "BoidRenderer.hpp"
+#include "DemoOptions.hpp"
+#include "TrajectoryPlayer.hpp"
+
+
+// Playback position in a recording: a fractional frame that moves at speed
+// recorded seconds per wall-clock second, and stops at the last frame.
+class ReplayClock {
+public:
+    ReplayClock(std::uint64_t frames, float dt)
+        : last(static_cast<double>(frames - 1)), dt(dt), position(0.0), speed(1.0), paused(false)
+    {}
+
+    void advance(float seconds) {
+        if (paused)
+            return;
+        position = std::min(last, position + seconds * speed / dt);
+        if (position >= last)
+            paused = true;
+    }
+
+    void togglePause() { paused = !paused; }
+    void faster() { speed = std::min(64.0, speed * 2.0); }
+    void slower() { speed = std::max(1.0 / 64.0, speed / 2.0); }
+
+    // Pauses on the frame count frames away from the shown one.
+    void step(int count) {
+        paused = true;
+        seek(std::floor(position) + count);
+    }
+
+    void seek(double frame) { position = std::max(0.0, std::min(last, frame)); }
+    void seekFraction(double fraction) { seek(std::round(last * fraction)); }
+
+    std::uint64_t frame() const { return static_cast<std::uint64_t>(position); }
+    float alpha() const { return static_cast<float>(position - std::floor(position)); }
+    double getSpeed() const { return speed; }
+
+private:
+    double last;
+    float dt;
+    double position;
+    double speed;
+    bool paused;
+};
+
+
+// Plays a file written with --record (see TrajectoryRecorder.hpp) instead of
+// simulating. Space pauses, Left/Right step one frame, Up/Down double or
+// halve the speed, 0-9 seek to that tenth of the run, Home/End to either end.
+// Headless, it decodes every frame and prints the final frame's checksum,
+// which matches the recording run's when velocities were stored raw.
+inline int runReplay(const DemoOptions& options)
+{
+    TrajectoryPlayer player(options.replay);
+    if (!player.isOpen())
+    {
+        std::fprintf(stderr, "cannot replay '%s'\n", options.replay);
+        return -1;
+    }
+    const TrajectoryHeader& header = player.getHeader();
+
+    if (options.headless)
+    {
+        HeadlessTimer timer;
+        for (std::uint64_t frame = 0; frame + 1 < player.frameCount(); ++frame)
+            player.decode(frame);
+        const FlockState& last = player.decode(player.frameCount() - 1);
+        double seconds = timer.seconds();
+
+        StateChecksum checksum;
+        for (std::size_t i = 0; i < last.size(); ++i)
+            checksum.addKinematic(last.get(i));
+        std::printf("Replay of %s: %llu agents x %llu frames (dt %.4f s, seed %u) in %.3f s\n",
+                    options.replay, static_cast<unsigned long long>(header.agents),
+                    static_cast<unsigned long long>(player.frameCount()), header.dt, header.seed, seconds);
+        std::printf("  checksum:   %016llx\n", static_cast<unsigned long long>(checksum.value()));
+        return 0;
+    }
+
+    sf::Texture boidTexture;
+    if (!boidTexture.loadFromFile("src/boid-sm.png"))
+    {
+        return -1;
+    }
+    BoidRenderer boids(boidTexture);
+
+    const float worldWidth = header.worldWidth > 0.f ? header.worldWidth : 640.f;
+    const float worldHeight = header.worldHeight > 0.f ? header.worldHeight : 480.f;
+    // Boids that moved further than this between two frames wrapped around.
+    const float wrapJump = std::min(worldWidth, worldHeight) / 2.f;
+    sf::RenderWindow window(sf::VideoMode(static_cast<unsigned>(worldWidth), static_cast<unsigned>(worldHeight)),
+                            "Replay");
+    window.setFramerateLimit(60);
+
+    ReplayClock replay(player.frameCount(), header.dt);
+    sf::Clock clock;
+    while (window.isOpen())
+    {
+        sf::Event event;
+        while (window.pollEvent(event))
+        {
+            if (event.type == sf::Event::Closed)
+                window.close();
+            if (event.type != sf::Event::KeyPressed)
+                continue;
+            sf::Keyboard::Key key = event.key.code;
+            if (key == sf::Keyboard::Space)
+                replay.togglePause();
+            else if (key == sf::Keyboard::Right)
+                replay.step(1);
+            else if (key == sf::Keyboard::Left)
+                replay.step(-1);
+            else if (key == sf::Keyboard::Up)
+                replay.faster();
+            else if (key == sf::Keyboard::Down)
+                replay.slower();
+            else if (key == sf::Keyboard::Home)
+                replay.seekFraction(0.0);
+            else if (key == sf::Keyboard::End)
+                replay.seekFraction(1.0);
+            else if (key >= sf::Keyboard::Num0 && key <= sf::Keyboard::Num9)
+                replay.seekFraction((key - sf::Keyboard::Num0) / 10.0);
+        }
+
+        replay.advance(clock.restart().asSeconds());
+        std::uint64_t frame = replay.frame();
+        if (replay.alpha() > 0.f && frame + 1 < player.frameCount())
+            boids.update(player.frame(frame), player.frame(frame + 1), replay.alpha(), wrapJump);
+        else
+            boids.update(player.frame(frame));
+
+        window.clear(sf::Color::White);
+        boids.draw(window);
+        window.display();
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+
+// Binary snapshots of simulation state for warm starts. A file is the magic
+// "FLOCKSNP" and a version, then whatever values and arrays its owners
+// write, read back in the same order. An array is a 64-bit count followed
+// by its raw elements, so restoring a million agents is a few large reads.
+// Host byte order; snapshots are not meant to move between machines.
+//
+// Both ends keep going after a failure and report it from ok(), so callers
+// can write or read a whole snapshot and check once at the end.
+class SnapshotWriter {
+public:
+    static constexpr std::uint32_t version = 3;
+
+    explicit SnapshotWriter(const char* path)
+        : file(std::fopen(path, "wb")), good(file != nullptr)
+    {
+        if (good)
+            good = std::fwrite("FLOCKSNP", 1, 8, file) == 8;
+        value(version);
+    }
+
+    ~SnapshotWriter() { close(); }
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    template <typename T>
+    void value(const T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot values are copied as bytes");
+        write(&v, sizeof(T));
+    }
+
+    template <typename T>
+    void array(const std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot arrays are copied as bytes");
+        value(static_cast<std::uint64_t>(v.size()));
+        write(v.data(), v.size() * sizeof(T));
+    }
+
+    // Flushes and closes the file; true if everything was written.
+    bool close() {
+        if (file) {
+            good = std::fclose(file) == 0 && good;
+            file = nullptr;
+        }
+        return good;
+    }
+
+    bool ok() const { return good; }
+
+private:
+    std::FILE* file;
+    bool good;
+
+    void write(const void* data, std::size_t bytes) {
+        if (good && bytes > 0)
+            good = std::fwrite(data, 1, bytes, file) == bytes;
+    }
+};
+
+
+class SnapshotReader {
+public:
+    explicit SnapshotReader(const char* path)
+        : file(std::fopen(path, "rb")), good(file != nullptr), remaining(0)
+    {
+        if (!good)
+            return;
+        std::fseek(file, 0, SEEK_END);
+        long size = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+        remaining = size > 0 ? static_cast<std::uint64_t>(size) : 0;
+        char magic[8];
+        std::uint32_t fileVersion = 0;
+        read(magic, sizeof(magic));
+        value(fileVersion);
+        good = good && std::memcmp(magic, "FLOCKSNP", 8) == 0 && fileVersion == SnapshotWriter::version;
+    }
+
+    ~SnapshotReader() {
+        if (file)
+            std::fclose(file);
+    }
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    template <typename T>
+    bool value(T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot values are copied as bytes");
+        return read(&v, sizeof(T));
+    }
+
+    template <typename T>
+    bool array(std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot arrays are copied as bytes");
+        std::uint64_t count = 0;
+        // A count the rest of the file cannot hold means a damaged file.
+        if (!value(count) || count > remaining / sizeof(T))
+            return good = false;
+        v.resize(static_cast<std::size_t>(count));
+        return read(v.data(), v.size() * sizeof(T));
+    }
+
+    // Marks the snapshot unusable, e.g. when it does not fit the caller.
+    void fail() { good = false; }
+
+    bool ok() const { return good; }
+
+private:
+    std::FILE* file;
+    bool good;
+    std::uint64_t remaining;
+
+    bool read(void* data, std::size_t bytes) {
+        if (good && bytes > 0) {
+            good = bytes <= remaining && std::fread(data, 1, bytes, file) == bytes;
+            remaining -= good ? bytes : 0;
+        }
+        return good;
+    }
+};
+
+#endif
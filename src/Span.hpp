@@ -0,0 +1,43 @@
+#ifndef SPAN_HPP
+#define SPAN_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+
+// Non-owning view of count contiguous Ts, a C++17 stand-in for std::span.
+// Span<const T> views read-only data; a Span<T> converts to it.
+template <typename T>
+class Span {
+public:
+    Span() : first(nullptr), count(0) {}
+    Span(T* data, std::size_t size) : first(data), count(size) {}
+
+    // Any contiguous container with data() and size(), e.g. std::vector.
+    template <typename Container,
+              typename = typename std::enable_if<
+                  std::is_convertible<decltype(std::declval<Container&>().data()), T*>::value>::type>
+    Span(Container& container) : first(container.data()), count(container.size()) {}
+
+    template <typename U,
+              typename = typename std::enable_if<std::is_convertible<U (*)[], T (*)[]>::value>::type>
+    Span(const Span<U>& other) : first(other.data()), count(other.size()) {}
+
+    T* data() const { return first; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](std::size_t i) const { return first[i]; }
+    T* begin() const { return first; }
+    T* end() const { return first + count; }
+
+    Span subspan(std::size_t offset, std::size_t length) const {
+        return Span(first + offset, length);
+    }
+
+private:
+    T* first;
+    std::size_t count;
+};
+
+#endif
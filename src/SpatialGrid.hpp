@@ -0,0 +1,109 @@
+#ifndef SPATIAL_GRID_HPP
+#define SPATIAL_GRID_HPP
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+
+// Uniform grid (cell list) over agent positions, rebuilt once per frame.
+// Agents are bucketed with a counting sort, so every cell is a contiguous
+// run of agent indices in ascending order.
+class SpatialGrid {
+public:
+    // cellSize should be at least the largest radius that will be queried,
+    // so a query only ever touches the 3x3 block around its cell.
+    explicit SpatialGrid(float cellSize)
+        : cellSize(cellSize), originX(0.f), originY(0.f), cols(0), rows(0)
+    {}
+
+    template <typename Agents>
+    void rebuild(const Agents& agents) {
+        rebuild(agents.size(), [&](std::size_t i) { return agents[i].position; });
+    }
+
+    // position(i) must return the sf::Vector2f position of agent i.
+    template <typename PositionFn>
+    void rebuild(std::size_t count, PositionFn position) {
+        cellOf.resize(count);
+        indices.resize(count);
+        if (count == 0) {
+            cols = rows = 0;
+            cellStart.assign(1, 0);
+            return;
+        }
+
+        // Bounds of the flock this frame; boids may sit slightly outside the window.
+        sf::Vector2f lo = position(0);
+        sf::Vector2f hi = lo;
+        for (std::size_t i = 1; i < count; ++i) {
+            sf::Vector2f p = position(i);
+            lo.x = std::min(lo.x, p.x); lo.y = std::min(lo.y, p.y);
+            hi.x = std::max(hi.x, p.x); hi.y = std::max(hi.y, p.y);
+        }
+        originX = lo.x;
+        originY = lo.y;
+        cols = static_cast<int>((hi.x - lo.x) / cellSize) + 1;
+        rows = static_cast<int>((hi.y - lo.y) / cellSize) + 1;
+
+        // Counting sort of agents by cell.
+        cellStart.assign(static_cast<std::size_t>(cols) * rows + 1, 0);
+        for (std::size_t i = 0; i < count; ++i) {
+            sf::Vector2f p = position(i);
+            int cell = cellY(p.y) * cols + cellX(p.x);
+            cellOf[i] = cell;
+            cellStart[cell + 1]++;
+        }
+        for (std::size_t c = 1; c < cellStart.size(); ++c)
+            cellStart[c] += cellStart[c - 1];
+        cursor.assign(cellStart.begin(), cellStart.end() - 1);
+        for (std::size_t i = 0; i < count; ++i)
+            indices[cursor[cellOf[i]]++] = static_cast<int>(i);
+    }
+
+    // Replaces out with the indices of every agent in the cells overlapping
+    // the square of half-width radius around p, in ascending order. Callers
+    // still do the exact distance test.
+    void query(const sf::Vector2f& p, float radius, std::vector<int>& out) const {
+        out.clear();
+        if (cols == 0)
+            return;
+        int x0 = cellX(p.x - radius), x1 = cellX(p.x + radius);
+        int y0 = cellY(p.y - radius), y1 = cellY(p.y + radius);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                int cell = y * cols + x;
+                out.insert(out.end(), indices.begin() + cellStart[cell],
+                           indices.begin() + cellStart[cell + 1]);
+            }
+        }
+        // Ascending order keeps the floating point sums identical to a linear scan.
+        std::sort(out.begin(), out.end());
+    }
+
+    float getCellSize() const { return cellSize; }
+
+private:
+    float cellSize;
+    float originX;
+    float originY;
+    int cols;
+    int rows;
+    std::vector<int> cellOf;     // cell of each agent
+    std::vector<int> cellStart;  // first slot in indices for each cell, plus an end marker
+    std::vector<int> cursor;
+    std::vector<int> indices;    // agent indices grouped by cell
+
+    int cellX(float x) const {
+        int c = static_cast<int>(std::floor((x - originX) / cellSize));
+        return std::max(0, std::min(cols - 1, c));
+    }
+    int cellY(float y) const {
+        int c = static_cast<int>(std::floor((y - originY) / cellSize));
+        return std::max(0, std::min(rows - 1, c));
+    }
+};
+
+#endif
@@ -5,6 +5,8 @@
 #include <cmath>
 #include <cstdlib>
 #include <vector>
+#include "CounterRandom.hpp"
+#include "Span.hpp"
 
 
 const float PI = 3.14159265f;
@@ -63,11 +65,44 @@ class SteeringBehavior {
 public:
     virtual ~SteeringBehavior() {}
     virtual SteeringOutput getSteering(const Kinematic& character, const Kinematic& target, float deltaTime) = 0;
+
+    // out[i] = getSteering(characters[i], targets[i], deltaTime) for every
+    // i < out.size(), with one virtual call for the whole batch.
+    virtual void getSteeringBatch(Span<const Kinematic> characters, Span<const Kinematic> targets,
+                                  Span<SteeringOutput> out, float deltaTime) {
+        for (std::size_t i = 0; i < out.size(); ++i)
+            out[i] = getSteering(characters[i], targets[i], deltaTime);
+    }
+};
+
+// CRTP base of the behaviors below. Each one implements a plain steer() that
+// templates (SteeringComposition.hpp) can call and inline directly; the
+// virtual getSteering is a thin wrapper around it. Likewise for batches: a
+// behavior may define its own steerBatch(), otherwise the one here loops
+// over steer().
+template <typename Derived>
+class StaticSteering : public SteeringBehavior {
+public:
+    virtual SteeringOutput getSteering(const Kinematic& character, const Kinematic& target, float deltaTime) override {
+        return static_cast<Derived*>(this)->steer(character, target, deltaTime);
+    }
+
+    virtual void getSteeringBatch(Span<const Kinematic> characters, Span<const Kinematic> targets,
+                                  Span<SteeringOutput> out, float deltaTime) override {
+        static_cast<Derived*>(this)->steerBatch(characters, targets, out, deltaTime);
+    }
+
+    void steerBatch(Span<const Kinematic> characters, Span<const Kinematic> targets,
+                    Span<SteeringOutput> out, float deltaTime) {
+        Derived& self = *static_cast<Derived*>(this);
+        for (std::size_t i = 0; i < out.size(); ++i)
+            out[i] = self.steer(characters[i], targets[i], deltaTime);
+    }
 };
 
 
 // Arrive
-class ArriveBehavior : public SteeringBehavior {
+class ArriveBehavior : public StaticSteering<ArriveBehavior> {
 public:
     ArriveBehavior(float maxAccel, float maxSpeed, float targetRadius, float slowRadius, float timeToTarget)
         : maxAcceleration(maxAccel), maxSpeed(maxSpeed),
@@ -75,7 +110,7 @@ public:
           timeToTarget(timeToTarget)
     {}
 
-    virtual SteeringOutput getSteering(const Kinematic& character, const Kinematic& target, float /*deltaTime*/) override {
+    SteeringOutput steer(const Kinematic& character, const Kinematic& target, float /*deltaTime*/) {
         SteeringOutput steering;
         sf::Vector2f direction = target.position - character.position;
         float distance = vectorLength(direction);
@@ -98,6 +133,24 @@ public:
         return steering;
     }
 
+    // Bit-identical to steer() per pair; the early return and the clamp
+    // become selects so the loop body has no data-dependent branches.
+    void steerBatch(Span<const Kinematic> characters, Span<const Kinematic> targets,
+                    Span<SteeringOutput> out, float /*deltaTime*/) {
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            sf::Vector2f direction = targets[i].position - characters[i].position;
+            float distance = vectorLength(direction);
+            float targetSpeed = (distance > slowRadius) ? maxSpeed : maxSpeed * distance / slowRadius;
+            sf::Vector2f unit = (distance != 0.f) ? direction / distance : direction;
+            sf::Vector2f linear = (unit * targetSpeed - characters[i].velocity) / timeToTarget;
+            float length = vectorLength(linear);
+            bool limited = length > maxAcceleration && length > 0.f;
+            linear = limited ? (linear / length) * maxAcceleration : linear;
+            out[i].linear = (distance < targetRadius) ? sf::Vector2f(0.f, 0.f) : linear;
+            out[i].angular = 0.f;
+        }
+    }
+
 private:
     float maxAcceleration;
     float maxSpeed;
@@ -108,7 +161,7 @@ private:
 
 
 // Align
-class AlignBehavior : public SteeringBehavior {
+class AlignBehavior : public StaticSteering<AlignBehavior> {
 public:
     AlignBehavior(float maxAngAccel, float maxRot, float satisfactionRadius,
                   float decelerationRadius, float timeToTarget)
@@ -117,7 +170,7 @@ public:
           timeToTarget(timeToTarget)
     {}
 
-    virtual SteeringOutput getSteering(const Kinematic& character, const Kinematic& target, float /*deltaTime*/) override {
+    SteeringOutput steer(const Kinematic& character, const Kinematic& target, float /*deltaTime*/) {
         SteeringOutput steering;
         float rotation = target.orientation - character.orientation;
         rotation = mapToRange(rotation);
@@ -139,6 +192,28 @@ public:
         return steering;
     }
 
+    // Bit-identical to steer() per pair. Differences of angles already in
+    // [-PI, PI] need one wrap at most, done with selects; anything further
+    // out falls back to mapToRange.
+    void steerBatch(Span<const Kinematic> characters, Span<const Kinematic> targets,
+                    Span<SteeringOutput> out, float /*deltaTime*/) {
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            float rotation = targets[i].orientation - characters[i].orientation;
+            rotation = (rotation > PI) ? rotation - 2 * PI : rotation;
+            rotation = (rotation < -PI) ? rotation + 2 * PI : rotation;
+            if (rotation > PI || rotation < -PI)
+                rotation = mapToRange(rotation);
+            float rotationSize = std::abs(rotation);
+            float desiredRotation = (rotationSize > decelerationRadius) ? maxRotation : maxRotation * rotationSize / decelerationRadius;
+            desiredRotation *= (rotation / rotationSize);
+            float angular = (desiredRotation - characters[i].rotation) / timeToTarget;
+            angular = (angular > maxAngularAcceleration) ? maxAngularAcceleration
+                    : (angular < -maxAngularAcceleration) ? -maxAngularAcceleration : angular;
+            out[i].angular = (rotationSize < satisfactionRadius) ? 0.f : angular;
+            out[i].linear = sf::Vector2f(0.f, 0.f);
+        }
+    }
+
 private:
     float maxAngularAcceleration;
     float maxRotation;
@@ -148,8 +223,14 @@ private:
 };
 
 
+// What a wander remembers between steps.
+struct WanderState {
+    float orientation;    // current offset on the wander circle
+    RandomStream random;
+};
+
 // Wander
-class WanderBehavior : public SteeringBehavior {
+class WanderBehavior : public StaticSteering<WanderBehavior> {
 public:
     WanderBehavior(float maxAccel, float maxSpeed,
                    float wanderOffset, float wanderRadius,
@@ -157,10 +238,25 @@ public:
         : maxAcceleration(maxAccel), maxSpeed(maxSpeed),
           wanderOffset(wanderOffset), wanderRadius(wanderRadius),
           wanderRate(wanderRate), timeToTarget(timeToTarget),
-          wanderOrientation(0.f)
+          wanderOrientation(0.f), random(0, static_cast<std::uint32_t>(std::rand())),
+          arrive(maxAccel, maxSpeed, 5.f, wanderRadius, timeToTarget)
     {}
 
-    virtual SteeringOutput getSteering(const Kinematic& character, const Kinematic& , float /*deltaTime*/) override {
+    // Each wander draws from its own counter-based stream, so separate agents
+    // can be stepped on separate threads and replayed from a seed. Give every
+    // agent sharing a seed its own stream (e.g. its index).
+    void seed(unsigned value, unsigned stream = 0) {
+        random = RandomStream(stream, value);
+    }
+
+    WanderState getState() const { return WanderState{ wanderOrientation, random }; }
+
+    void setState(const WanderState& state) {
+        wanderOrientation = state.orientation;
+        random = state.random;
+    }
+
+    SteeringOutput steer(const Kinematic& character, const Kinematic& , float /*deltaTime*/) {
         // update wander with random binomial value.
         wanderOrientation += randomBinomial() * wanderRate;
         float targetOrientation = character.orientation + wanderOrientation;
@@ -180,8 +276,7 @@ public:
         dummyTarget.velocity = sf::Vector2f(0.f, 0.f);
         dummyTarget.orientation = 0.f;
         dummyTarget.rotation = 0.f;
-        ArriveBehavior arrive(maxAcceleration, maxSpeed, 5.f, wanderRadius, timeToTarget);
-        return arrive.getSteering(character, dummyTarget, 0.f);
+        return arrive.steer(character, dummyTarget, 0.f);
     }
     
 private:
@@ -192,10 +287,12 @@ private:
     float wanderRate;
     float timeToTarget;
     float wanderOrientation;
+    RandomStream random;
+    ArriveBehavior arrive;   // steers towards the point on the wander circle
 
     
     float randomBinomial() {
-        return ((float)std::rand() / RAND_MAX) - ((float)std::rand() / RAND_MAX);
+        return random.binomial();
     }
 };
 
@@ -203,13 +300,13 @@ private:
 
 // Velocity Matching Behavior
 
-class VelocityMatchingBehavior : public SteeringBehavior {
+class VelocityMatchingBehavior : public StaticSteering<VelocityMatchingBehavior> {
 public:
     VelocityMatchingBehavior(float maxAccel, float timeToTarget)
         : maxAcceleration(maxAccel), timeToTarget(timeToTarget)
     {}
 
-    virtual SteeringOutput getSteering(const Kinematic& character, const Kinematic& target, float /*deltaTime*/) override {
+    SteeringOutput steer(const Kinematic& character, const Kinematic& target, float /*deltaTime*/) {
         SteeringOutput steering;
         // Calculating acceleration needed to match target velocity
         steering.linear = (target.velocity - character.velocity) / timeToTarget;
@@ -218,6 +315,18 @@ public:
         return steering;
     }
 
+    // Bit-identical to steer() per pair, with the clamp as a select.
+    void steerBatch(Span<const Kinematic> characters, Span<const Kinematic> targets,
+                    Span<SteeringOutput> out, float /*deltaTime*/) {
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            sf::Vector2f linear = (targets[i].velocity - characters[i].velocity) / timeToTarget;
+            float length = vectorLength(linear);
+            bool limited = length > maxAcceleration && length > 0.f;
+            out[i].linear = limited ? (linear / length) * maxAcceleration : linear;
+            out[i].angular = 0.f;
+        }
+    }
+
 private:
     float maxAcceleration;
     float timeToTarget;
@@ -227,13 +336,13 @@ private:
 
 // Rotation Matching Behavior
 
-class RotationMatchingBehavior : public SteeringBehavior {
+class RotationMatchingBehavior : public StaticSteering<RotationMatchingBehavior> {
 public:
     RotationMatchingBehavior(float maxAngAccel, float timeToTarget)
         : maxAngularAcceleration(maxAngAccel), timeToTarget(timeToTarget)
     {}
 
-    virtual SteeringOutput getSteering(const Kinematic& character, const Kinematic& target, float /*deltaTime*/) override {
+    SteeringOutput steer(const Kinematic& character, const Kinematic& target, float /*deltaTime*/) {
         SteeringOutput steering;
         float rotationDiff = target.rotation - character.rotation;
         steering.angular = rotationDiff / timeToTarget;
@@ -242,77 +351,20 @@ public:
         return steering;
     }
 
-private:
-    float maxAngularAcceleration;
-    float timeToTarget;
-};
-
-// Flocking Behavior
-
-class FlockingBehavior : public SteeringBehavior {
-public:
-    FlockingBehavior(const std::vector<Kinematic>* flock,
-                     float neighborRadius, float separationRadius,
-                     float separationWeight, float alignmentWeight, float cohesionWeight,
-                     float maxAcceleration,
-                     //wander params
-                     float wanderMaxAccel, float wanderMaxSpeed, float wanderOffset,
-                     float wanderRadius, float wanderRate, float wanderTimeToTarget)
-        : flock(flock), neighborRadius(neighborRadius), separationRadius(separationRadius),
-          separationWeight(separationWeight), alignmentWeight(alignmentWeight), cohesionWeight(cohesionWeight),
-          maxAcceleration(maxAcceleration),
-          wander(wanderMaxAccel, wanderMaxSpeed, wanderOffset, wanderRadius, wanderRate, wanderTimeToTarget)
-    {}
-
-    virtual SteeringOutput getSteering(const Kinematic& character, const Kinematic& /*unused*/, float deltaTime) override {
-        sf::Vector2f separation(0.f, 0.f);
-        sf::Vector2f alignment(0.f, 0.f);
-        sf::Vector2f cohesion(0.f, 0.f);
-        int count = 0;
-        for (const auto& other : *flock) {
-            if (&other == &character)
-                continue;
-            sf::Vector2f toOther = other.position - character.position;
-            float distance = vectorLength(toOther);
-            if (distance < neighborRadius && distance > 0.f) {
-                alignment += other.velocity;
-                cohesion += other.position;
-                count++;
-                if (distance < separationRadius) {
-                    separation += (character.position - other.position) / distance;
-                }
-            }
+    // Bit-identical to steer() per pair, with the clamp as a select.
+    void steerBatch(Span<const Kinematic> characters, Span<const Kinematic> targets,
+                    Span<SteeringOutput> out, float /*deltaTime*/) {
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            float angular = (targets[i].rotation - characters[i].rotation) / timeToTarget;
+            out[i].angular = (angular > maxAngularAcceleration) ? maxAngularAcceleration
+                           : (angular < -maxAngularAcceleration) ? -maxAngularAcceleration : angular;
+            out[i].linear = sf::Vector2f(0.f, 0.f);
         }
-        
-        SteeringOutput steering;
-        if (count == 0) {
-            // If no neighbors, use wander
-            return wander.getSteering(character, character, deltaTime);
-        }
-        
-        alignment = alignment / static_cast<float>(count);
-        cohesion = (cohesion / static_cast<float>(count)) - character.position;
-        
-
-        sf::Vector2f flockingForce = separation * separationWeight +
-                                     alignment * alignmentWeight +
-                                     cohesion * cohesionWeight;
-        flockingForce = clamp(flockingForce, maxAcceleration);
-        
-        steering.linear = flockingForce;
-        steering.angular = 0.f;
-        return steering;
     }
 
 private:
-    const std::vector<Kinematic>* flock;
-    float neighborRadius;
-    float separationRadius;
-    float separationWeight;
-    float alignmentWeight;
-    float cohesionWeight;
-    float maxAcceleration;
-    WanderBehavior wander;
+    float maxAngularAcceleration;
+    float timeToTarget;
 };
 
 #endif 
@@ -0,0 +1,277 @@
+#ifndef STEERING_COMPOSITION_HPP
+#define STEERING_COMPOSITION_HPP
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "Span.hpp"
+#include "Steering.hpp"
+#include "FlockKernel.hpp"
+
+
+// Compile-time composition of behaviors. Everything here calls the plain
+// steer() of its parts, so a whole pipeline such as
+// Limit<Blend<Separation, Alignment, Cohesion>> inlines into the per-agent
+// loop with no virtual calls. Any type with a matching steer() can take
+// part: the StaticSteering behaviors of Steering.hpp take
+// (character, target, deltaTime), the flock terms below take a
+// SteeringContext.
+
+
+// Weighted sum of the behaviors' outputs; every part gets the same
+// arguments.
+template <typename... Behaviors>
+class Blend {
+public:
+    typedef std::array<float, sizeof...(Behaviors)> Weights;
+
+    Blend(const Weights& weights, Behaviors... behaviors)
+        : weights(weights), behaviors(std::move(behaviors)...)
+    {}
+
+    template <typename... Args>
+    SteeringOutput steer(const Args&... args) {
+        SteeringOutput out{ sf::Vector2f(0.f, 0.f), 0.f };
+        accumulate(out, std::index_sequence_for<Behaviors...>(), args...);
+        return out;
+    }
+
+    // Batch form for parts with a steerBatch (the StaticSteering behaviors):
+    // every part runs its own batch kernel over the spans, then its outputs
+    // are weighted in.
+    void steerBatch(Span<const Kinematic> characters, Span<const Kinematic> targets,
+                    Span<SteeringOutput> out, float deltaTime) {
+        scratch.resize(out.size());
+        std::fill(out.begin(), out.end(), SteeringOutput{ sf::Vector2f(0.f, 0.f), 0.f });
+        accumulateBatch(characters, targets, out, deltaTime, std::index_sequence_for<Behaviors...>());
+    }
+
+    template <std::size_t I>
+    auto& get() { return std::get<I>(behaviors); }
+
+private:
+    Weights weights;
+    std::tuple<Behaviors...> behaviors;
+    std::vector<SteeringOutput> scratch;  // one part's batch output
+
+    template <std::size_t... I, typename... Args>
+    void accumulate(SteeringOutput& out, std::index_sequence<I...>, const Args&... args) {
+        (add(out, std::get<I>(behaviors).steer(args...), weights[I]), ...);
+    }
+
+    template <std::size_t... I>
+    void accumulateBatch(Span<const Kinematic> characters, Span<const Kinematic> targets,
+                         Span<SteeringOutput> out, float deltaTime, std::index_sequence<I...>) {
+        (addBatch(std::get<I>(behaviors), weights[I], characters, targets, out, deltaTime), ...);
+    }
+
+    template <typename Behavior>
+    void addBatch(Behavior& behavior, float weight, Span<const Kinematic> characters,
+                  Span<const Kinematic> targets, Span<SteeringOutput> out, float deltaTime) {
+        behavior.steerBatch(characters, targets, scratch, deltaTime);
+        for (std::size_t i = 0; i < out.size(); ++i)
+            add(out[i], scratch[i], weight);
+    }
+
+    static void add(SteeringOutput& out, const SteeringOutput& part, float weight) {
+        out.linear += part.linear * weight;
+        out.angular += part.angular * weight;
+    }
+};
+
+
+// The acceleration budget of Behavior: caps its linear acceleration at
+// maxLinear and its angular acceleration at maxAngular.
+template <typename Behavior>
+class Limit {
+public:
+    Limit(float maxLinear, Behavior behavior,
+          float maxAngular = std::numeric_limits<float>::infinity())
+        : maxLinear(maxLinear), maxAngular(maxAngular), behavior(std::move(behavior))
+    {}
+
+    template <typename... Args>
+    SteeringOutput steer(const Args&... args) {
+        SteeringOutput out = behavior.steer(args...);
+        out.linear = clamp(out.linear, maxLinear);
+        out.angular = clamp(out.angular, maxAngular);
+        return out;
+    }
+
+    Behavior& get() { return behavior; }
+
+private:
+    float maxLinear;
+    float maxAngular;
+    Behavior behavior;
+};
+
+
+// Priority arbitration: the groups are tried in order and the first one
+// whose output exceeds epsilon (in linear length or angular magnitude)
+// wins; later groups are not evaluated at all. A When group whose
+// predicate fails is skipped without being evaluated. If no group wins,
+// the output of the last group evaluated is returned. Groups are usually
+// Limit<Blend<...>>.
+template <typename... Groups>
+class Priority {
+public:
+    Priority(float epsilon, Groups... groups)
+        : epsilon(epsilon), groups(std::move(groups)...)
+    {}
+
+    template <typename... Args>
+    SteeringOutput steer(const Args&... args) {
+        SteeringOutput out{ sf::Vector2f(0.f, 0.f), 0.f };
+        first(out, std::index_sequence_for<Groups...>(), args...);
+        return out;
+    }
+
+    template <std::size_t I>
+    auto& get() { return std::get<I>(groups); }
+    template <std::size_t I>
+    const auto& get() const { return std::get<I>(groups); }
+
+private:
+    float epsilon;
+    std::tuple<Groups...> groups;
+
+    template <std::size_t... I, typename... Args>
+    void first(SteeringOutput& out, std::index_sequence<I...>, const Args&... args) {
+        // || stops the fold at the first active group.
+        (tryGroup(out, std::get<I>(groups), args...) || ...);
+    }
+
+    template <typename Group, typename... Args>
+    bool tryGroup(SteeringOutput& out, Group& group, const Args&... args) {
+        if (!applies(group, 0, args...))
+            return false;
+        out = group.steer(args...);
+        return active(out);
+    }
+
+    // Groups without an applies() (anything but When) always apply.
+    template <typename Group, typename... Args>
+    static auto applies(const Group& group, int, const Args&... args) -> decltype(group.applies(args...)) {
+        return group.applies(args...);
+    }
+    template <typename Group, typename... Args>
+    static bool applies(const Group&, long, const Args&...) { return true; }
+
+    bool active(const SteeringOutput& out) const {
+        float lengthSquared = out.linear.x * out.linear.x + out.linear.y * out.linear.y;
+        return lengthSquared > epsilon * epsilon || std::abs(out.angular) > epsilon;
+    }
+};
+
+
+// A Priority group that only runs where predicate(args...) holds.
+template <typename Predicate, typename Group>
+class When {
+public:
+    When(Predicate predicate, Group group)
+        : predicate(std::move(predicate)), group(std::move(group))
+    {}
+
+    template <typename... Args>
+    bool applies(const Args&... args) const { return predicate(args...); }
+
+    template <typename... Args>
+    SteeringOutput steer(const Args&... args) { return group.steer(args...); }
+
+    Group& get() { return group; }
+    const Group& get() const { return group; }
+
+private:
+    Predicate predicate;
+    Group group;
+};
+
+
+// A boid's position and the sums over its neighbors (see FlockKernel).
+struct FlockNeighborhood {
+    sf::Vector2f position;
+    FlockSums sums;
+};
+
+// Everything one agent's pipeline may look at. The neighborhood comes from
+// a single pass over the neighbors that fills every sum at once, so the
+// flock terms below share it and adding one costs no further scan.
+struct SteeringContext {
+    const Kinematic& character;
+    const Kinematic& target;
+    float deltaTime;
+    FlockNeighborhood neighborhood;
+};
+
+// Runs a (character, target, deltaTime) behavior on a SteeringContext, so
+// it can sit in the same Blend or Priority as the flock terms.
+template <typename Behavior>
+class OnKinematics {
+public:
+    explicit OnKinematics(Behavior behavior) : behavior(std::move(behavior)) {}
+
+    SteeringOutput steer(const SteeringContext& c) {
+        return behavior.steer(c.character, c.target, c.deltaTime);
+    }
+
+    Behavior& get() { return behavior; }
+    const Behavior& get() const { return behavior; }
+
+private:
+    Behavior behavior;
+};
+
+// Predicate for When: the boid found no neighbors.
+struct NoNeighbors {
+    bool operator()(const SteeringContext& c) const { return c.neighborhood.sums.count == 0; }
+};
+
+// The flock terms give no steering without neighbors.
+
+// Away from close neighbors, weighted by inverse distance.
+struct Separation {
+    SteeringOutput steer(const SteeringContext& c) const {
+        return SteeringOutput{ c.neighborhood.sums.separation, 0.f };
+    }
+};
+
+// Towards the neighbors' average velocity.
+struct Alignment {
+    SteeringOutput steer(const SteeringContext& c) const {
+        const FlockSums& sums = c.neighborhood.sums;
+        if (sums.count == 0)
+            return SteeringOutput{ sf::Vector2f(0.f, 0.f), 0.f };
+        return SteeringOutput{ sums.alignment / static_cast<float>(sums.count), 0.f };
+    }
+};
+
+// Towards the neighbors' center.
+struct Cohesion {
+    SteeringOutput steer(const SteeringContext& c) const {
+        const FlockSums& sums = c.neighborhood.sums;
+        if (sums.count == 0)
+            return SteeringOutput{ sf::Vector2f(0.f, 0.f), 0.f };
+        return SteeringOutput{ (sums.cohesion / static_cast<float>(sums.count)) - c.neighborhood.position, 0.f };
+    }
+};
+
+
+// A closed set of behaviors stored by value: agents of different kinds can
+// share one array without a heap allocation or vtable per agent.
+typedef std::variant<ArriveBehavior, AlignBehavior, WanderBehavior,
+                     VelocityMatchingBehavior, RotationMatchingBehavior> AnyBehavior;
+
+inline SteeringOutput steerAny(AnyBehavior& behavior, const Kinematic& character,
+                               const Kinematic& target, float deltaTime) {
+    return std::visit([&](auto& b) { return b.steer(character, target, deltaTime); }, behavior);
+}
+
+#endif
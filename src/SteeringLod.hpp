@@ -0,0 +1,150 @@
+#ifndef STEERING_LOD_HPP
+#define STEERING_LOD_HPP
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Snapshot.hpp"
+
+
+// How often each agent's steering is recomputed. Intervals are powers of
+// two frames; between updates an agent keeps its last SteeringOutput.
+struct SteeringLodParams {
+    bool enabled = false;
+    int isolatedInterval = 4;   // agents whose last steering found no neighbors (wander only)
+    int offscreenInterval = 4;  // agents outside the view, if one is set
+    int budget = 0;             // steering updates per frame; 0 for no limit
+};
+
+
+// Time-sliced steering scheduler. Once per frame, plan() picks every agent's
+// interval from its last neighbor count and whether it is in view; an agent
+// is then due on the frames where (frame + id) is a multiple of its
+// interval, so agents sharing an interval are staggered evenly over the
+// frames instead of all updating together. id is a stable per-agent number
+// in [0, count), not the agent's index: a simulation that reorders its
+// agents (FlockSimulation::sortBoids) would otherwise shift their phases
+// and could skip an agent for many intervals in a row. When the expected
+// updates per frame exceed the budget, every interval is doubled until
+// they fit.
+//
+// Agents are all due on the first frame and whenever the agent count changes.
+class SteeringLod {
+public:
+    static const int maxShift = 6;  // budget doubling stops at 64x
+
+    explicit SteeringLod(const SteeringLodParams& params = SteeringLodParams())
+        : params(params), frame(0), shift(0), planned(0), allDue(true), updates(0), agentFrames(0),
+          longestInterval(1), longestGap(0)
+    {}
+
+    bool isEnabled() const { return params.enabled; }
+
+    // Sets what is on screen; an empty rectangle means everything is.
+    void setView(const sf::FloatRect& rect) { view = rect; }
+
+    // Starts a frame. neighborCount(i) is agent i's neighbor count from its
+    // last steering update and id(i) its stable id.
+    template <typename PositionFn, typename CountFn, typename IdFn>
+    void plan(std::size_t count, PositionFn position, CountFn neighborCount, IdFn id) {
+        frame++;
+        allDue = count != planned;
+        planned = count;
+        intervals.resize(count);
+        if (allDue || lastUpdate.size() != count) {
+            lastUpdate.assign(count, frame);
+            if (allDue) {
+                shift = 0;
+                updates += count;
+                agentFrames += count;
+                return;
+            }
+        }
+        bool culling = view.width > 0.f && view.height > 0.f;
+        double load = 0.0;
+        for (std::size_t i = 0; i < count; ++i) {
+            int interval = 1;
+            if (neighborCount(i) == 0)
+                interval = roundInterval(params.isolatedInterval);
+            if (culling && !view.contains(position(i)))
+                interval = std::max(interval, roundInterval(params.offscreenInterval));
+            intervals[i] = static_cast<std::uint8_t>(interval);
+            load += 1.0 / interval;
+        }
+        shift = 0;
+        while (params.budget > 0 && load > params.budget && shift < maxShift) {
+            load /= 2.0;
+            shift++;
+        }
+        std::size_t due = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            longestInterval = std::max<std::uint64_t>(longestInterval,
+                                                      static_cast<std::uint64_t>(intervals[i]) << shift);
+            std::size_t agent = id(i);
+            if (!isDue(i, agent))
+                continue;
+            due++;
+            longestGap = std::max(longestGap, frame - lastUpdate[agent]);
+            lastUpdate[agent] = frame;
+        }
+        updates += due;
+        agentFrames += count;
+    }
+
+    bool isDue(std::size_t i, std::size_t id) const {
+        if (!params.enabled || allDue)
+            return true;
+        std::uint64_t mask = (static_cast<std::uint64_t>(intervals[i]) << shift) - 1;
+        return ((frame + id) & mask) == 0;
+    }
+
+    // Steering updates and agent-frames planned so far.
+    std::uint64_t getUpdateCount() const { return updates; }
+    std::uint64_t getAgentFrameCount() const { return agentFrames; }
+    // Longest interval planned so far, budget doubling included, and the
+    // most frames any agent actually went between two updates; the gap
+    // never exceeds the interval.
+    std::uint64_t getLongestInterval() const { return longestInterval; }
+    std::uint64_t getLongestGap() const { return longestGap; }
+    const SteeringLodParams& getParams() const { return params; }
+
+    // The frame counter is the only state plan() does not rebuild.
+    void save(SnapshotWriter& out) const {
+        out.value(frame);
+        out.value(static_cast<std::uint64_t>(planned));
+    }
+
+    bool load(SnapshotReader& in) {
+        std::uint64_t count = 0;
+        in.value(frame);
+        in.value(count);
+        planned = static_cast<std::size_t>(count);
+        return in.ok();
+    }
+
+private:
+    SteeringLodParams params;
+    sf::FloatRect view;
+    std::uint64_t frame;
+    int shift;                          // budget doubling of every interval
+    std::size_t planned;                // agent count of the last plan
+    bool allDue;
+    std::vector<std::uint8_t> intervals;
+    std::uint64_t updates;
+    std::uint64_t agentFrames;
+    std::vector<std::uint64_t> lastUpdate;  // frame of each id's last update
+    std::uint64_t longestInterval;
+    std::uint64_t longestGap;
+
+    // The power of two at or below interval, in [1, 64].
+    static int roundInterval(int interval) {
+        int rounded = 1;
+        while (rounded * 2 <= interval && rounded < 64)
+            rounded *= 2;
+        return rounded;
+    }
+};
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef TRAIL_BUFFER_HPP
+#define TRAIL_BUFFER_HPP
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "Snapshot.hpp"
+
+
+// How crumbs are drawn. Each crumb is a filled regular polygon centered on
+// the dropped position.
+struct TrailStyle {
+    float radius = 1.5f;
+    sf::Color color = sf::Color(0, 0, 255, 255);
+    int sides = 8;
+    float fadeTime = 0.f;  // seconds until a crumb is fully transparent; 0 never fades
+};
+
+
+// Breadcrumb trails for a whole group of agents. All of them live in one flat
+// ring buffer: trail t owns slots [t * length, (t + 1) * length), and each
+// slot holds only the position and the time it was dropped. draw() emits
+// every crumb into one vertex array and issues one draw call.
+//
+// Call advance() once per frame, then update() per agent. Trails share no
+// state, so different trails may be updated on different threads.
+class TrailBuffer {
+public:
+    // firstDrop is the delay before a trail's first crumb; < 0 means
+    // dropInterval.
+    TrailBuffer(std::size_t trails = 0, std::size_t length = 10,
+                float dropInterval = 0.2f, float firstDrop = -1.f)
+        : length(length), dropInterval(dropInterval),
+          firstDrop(firstDrop < 0.f ? dropInterval : firstDrop),
+          now(0.f), frameDelta(0.f), vertices(sf::Triangles)
+    {
+        for (std::size_t t = 0; t < trails; ++t)
+            addTrail();
+    }
+
+    std::size_t addTrail() {
+        points.resize(points.size() + length, sf::Vector2f(0.f, 0.f));
+        times.resize(times.size() + length, -1.f);  // < 0: slot is empty
+        heads.push_back(0);
+        timers.push_back(firstDrop);
+        return heads.size() - 1;
+    }
+
+    void setStyle(const TrailStyle& value) {
+        style = value;
+    }
+
+    void advance(float deltaTime) {
+        now += deltaTime;
+        frameDelta = deltaTime;
+    }
+
+    // Drops position into trail once every dropInterval seconds.
+    void update(std::size_t trail, const sf::Vector2f& position) {
+        timers[trail] -= frameDelta;
+        if (timers[trail] <= 0.f) {
+            timers[trail] = dropInterval;
+            drop(trail, position);
+        }
+    }
+
+    // Overwrites the trail's oldest crumb.
+    void drop(std::size_t trail, const sf::Vector2f& position) {
+        std::size_t slot = trail * length + heads[trail];
+        points[slot] = position;
+        times[slot] = now;
+        heads[trail] = (heads[trail] + 1) % static_cast<unsigned>(length);
+    }
+
+    void draw(sf::RenderTarget& target) {
+        buildVertices();
+        if (vertices.getVertexCount() > 0)
+            target.draw(vertices);
+    }
+
+    const sf::VertexArray& buildVertices() {
+        const int sides = style.sides < 3 ? 3 : style.sides;
+        std::vector<sf::Vector2f> rim(sides + 1);
+        for (int k = 0; k <= sides; ++k) {
+            float angle = 2.f * 3.14159265f * k / sides;
+            rim[k] = sf::Vector2f(std::cos(angle), std::sin(angle)) * style.radius;
+        }
+
+        vertices.clear();
+        for (std::size_t slot = 0; slot < points.size(); ++slot) {
+            if (times[slot] < 0.f)
+                continue;
+            sf::Color color = style.color;
+            if (style.fadeTime > 0.f) {
+                float remaining = 1.f - (now - times[slot]) / style.fadeTime;
+                if (remaining <= 0.f)
+                    continue;
+                color.a = static_cast<sf::Uint8>(color.a * remaining);
+            }
+            const sf::Vector2f& center = points[slot];
+            for (int k = 0; k < sides; ++k) {
+                vertices.append(sf::Vertex(center, color));
+                vertices.append(sf::Vertex(center + rim[k], color));
+                vertices.append(sf::Vertex(center + rim[k + 1], color));
+            }
+        }
+        return vertices;
+    }
+
+    // Takes what draw() reads from from: crumbs, heads, clock and style.
+    // This buffer's own vertex array and drop timers are left alone, so a
+    // render-side copy keeps the capacity it built and copies no scratch.
+    void copyForDrawing(const TrailBuffer& from) {
+        length = from.length;
+        now = from.now;
+        style = from.style;
+        points.assign(from.points.begin(), from.points.end());
+        times.assign(from.times.begin(), from.times.end());
+        heads.assign(from.heads.begin(), from.heads.end());
+    }
+
+    // Trail k becomes the old trail order[k], crumbs, head and timer, so
+    // trails follow their agents when the agents are reordered. Done in
+    // place one cycle of the permutation at a time, holding one trail
+    // aside, so re-sorting allocates nothing once the scratch is sized.
+    void permute(const std::vector<std::uint32_t>& order) {
+        placed.assign(order.size(), 0);
+        heldPoints.resize(length);
+        heldTimes.resize(length);
+        for (std::size_t k = 0; k < order.size(); ++k) {
+            if (placed[k])
+                continue;
+            std::copy(points.begin() + k * length, points.begin() + (k + 1) * length, heldPoints.begin());
+            std::copy(times.begin() + k * length, times.begin() + (k + 1) * length, heldTimes.begin());
+            unsigned heldHead = heads[k];
+            float heldTimer = timers[k];
+            std::size_t to = k;
+            for (std::size_t from = order[k]; from != k; from = order[from]) {
+                std::copy(points.begin() + from * length, points.begin() + (from + 1) * length,
+                          points.begin() + to * length);
+                std::copy(times.begin() + from * length, times.begin() + (from + 1) * length,
+                          times.begin() + to * length);
+                heads[to] = heads[from];
+                timers[to] = timers[from];
+                placed[to] = 1;
+                to = from;
+            }
+            std::copy(heldPoints.begin(), heldPoints.end(), points.begin() + to * length);
+            std::copy(heldTimes.begin(), heldTimes.end(), times.begin() + to * length);
+            heads[to] = heldHead;
+            timers[to] = heldTimer;
+            placed[to] = 1;
+        }
+    }
+
+    // Every crumb, head and timer. Style and drop settings are the owner's
+    // and are not saved; load() fails if the trail length differs.
+    void save(SnapshotWriter& out) const {
+        out.value(static_cast<std::uint64_t>(length));
+        out.value(now);
+        out.array(points);
+        out.array(times);
+        out.array(heads);
+        out.array(timers);
+    }
+
+    bool load(SnapshotReader& in) {
+        std::uint64_t savedLength = 0;
+        in.value(savedLength);
+        in.value(now);
+        in.array(points);
+        in.array(times);
+        in.array(heads);
+        in.array(timers);
+        if (savedLength != length || points.size() != heads.size() * length ||
+            times.size() != points.size() || timers.size() != heads.size())
+            in.fail();
+        return in.ok();
+    }
+
+    std::size_t trailCount() const { return heads.size(); }
+    std::size_t getLength() const { return length; }
+    float getTime() const { return now; }
+
+    // Storage per crumb slot: position, drop time and a share of the
+    // per-trail head and timer. The vertex array built for drawing is not
+    // counted; it is scratch that is rebuilt every frame.
+    double bytesPerPoint() const {
+        std::size_t slots = points.size();
+        if (slots == 0)
+            return 0.0;
+        std::size_t bytes = points.size() * sizeof(sf::Vector2f) + times.size() * sizeof(float) +
+                            heads.size() * sizeof(unsigned) + timers.size() * sizeof(float);
+        return static_cast<double>(bytes) / slots;
+    }
+
+private:
+    std::size_t length;
+    float dropInterval;
+    float firstDrop;
+    float now;
+    float frameDelta;
+    std::vector<sf::Vector2f> points;
+    std::vector<float> times;
+    std::vector<unsigned> heads;   // next slot to overwrite, per trail
+    std::vector<float> timers;     // seconds until the next drop, per trail
+    TrailStyle style;
+    sf::VertexArray vertices;
+    // Scratch for permute().
+    std::vector<char> placed;
+    std::vector<sf::Vector2f> heldPoints;
+    std::vector<float> heldTimes;
+};
+
+// One line for the headless reports.
+inline void reportTrails(const TrailBuffer& trails) {
+    std::printf("  trails:     %zu x %zu points, %.1f bytes/point\n",
+                trails.trailCount(), trails.getLength(), trails.bytesPerPoint());
+}
+
+#endif
@@ -0,0 +1,215 @@
+#ifndef TRAJECTORY_FORMAT_HPP
+#define TRAJECTORY_FORMAT_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "FlockState.hpp"
+
+
+// On-disk layout of a recorded run, in host byte order:
+//
+//   TrajectoryHeader (1024 bytes)
+//   frame 0, frame 1, ...   fixed-size blocks, see TrajectoryLayout
+//
+// A frame block stores the flock column by column, N floats each:
+// x, y, orientation, rotation, then the velocity. Keyframes store vx and vy
+// as floats. With velocity deltas on, the frames between keyframes store
+// them as int16 steps from the previous frame: one float scale per column,
+// then N int16s for vx and N for vy, padded to 4 bytes. The encoder steps
+// from the velocities the decoder will reconstruct, so the error stays
+// below scale / 2 instead of accumulating; positions and orientations are
+// always exact.
+struct TrajectoryHeader {
+    enum Flags : std::uint32_t { VelocityDeltas = 1u };
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint64_t agents;
+    std::uint64_t frames;             // 0 if the recorder never finished
+    float dt;
+    std::uint32_t seed;
+    std::uint32_t keyframeInterval;   // 1 without velocity deltas
+    float worldWidth;
+    float worldHeight;
+    std::uint32_t reserved;
+    char params[968];                 // "name=value" lines, NUL-terminated
+
+    static const std::uint32_t currentVersion = 1;
+
+    static TrajectoryHeader make(std::uint64_t agents, float dt, std::uint32_t seed,
+                                 const std::string& params) {
+        TrajectoryHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "FLOCKTRJ", 8);
+        header.version = currentVersion;
+        header.agents = agents;
+        header.dt = dt;
+        header.seed = seed;
+        header.keyframeInterval = 1;
+        std::strncpy(header.params, params.c_str(), sizeof(header.params) - 1);
+        return header;
+    }
+
+    bool valid() const {
+        return std::memcmp(magic, "FLOCKTRJ", 8) == 0 && version == currentVersion
+            && keyframeInterval > 0;
+    }
+
+    bool velocityDeltas() const { return (flags & VelocityDeltas) != 0; }
+};
+
+static_assert(sizeof(TrajectoryHeader) == 1024, "TrajectoryHeader must stay 1024 bytes");
+
+
+// Sizes and offsets of the frame blocks described by a header.
+class TrajectoryLayout {
+public:
+    explicit TrajectoryLayout(const TrajectoryHeader& header)
+        : agents(static_cast<std::size_t>(header.agents)),
+          interval(header.velocityDeltas() ? header.keyframeInterval : 1)
+    {}
+
+    std::size_t keyframeBytes() const { return 6 * agents * sizeof(float); }
+
+    std::size_t deltaBytes() const {
+        std::size_t packed = 2 * agents * sizeof(std::int16_t);
+        return 4 * agents * sizeof(float) + 2 * sizeof(float) + (packed + 3) / 4 * 4;
+    }
+
+    bool isKeyframe(std::uint64_t frame) const { return frame % interval == 0; }
+
+    std::size_t frameBytes(std::uint64_t frame) const {
+        return isKeyframe(frame) ? keyframeBytes() : deltaBytes();
+    }
+
+    // Bytes from the end of the header to the start of frame.
+    std::uint64_t offset(std::uint64_t frame) const {
+        std::uint64_t group = keyframeBytes() + (interval - 1) * static_cast<std::uint64_t>(deltaBytes());
+        std::uint64_t inGroup = frame % interval;
+        std::uint64_t bytes = (frame / interval) * group;
+        if (inGroup > 0)
+            bytes += keyframeBytes() + (inGroup - 1) * static_cast<std::uint64_t>(deltaBytes());
+        return bytes;
+    }
+
+    // Whole frames in payloadBytes of data after the header.
+    std::uint64_t framesIn(std::uint64_t payloadBytes) const {
+        std::uint64_t frames = 0;
+        while (offset(frames) + frameBytes(frames) <= payloadBytes)
+            ++frames;
+        return frames;
+    }
+
+    std::size_t getAgents() const { return agents; }
+    std::uint32_t getKeyframeInterval() const { return interval; }
+
+private:
+    std::size_t agents;
+    std::uint32_t interval;
+};
+
+
+// Turns flock states into frame blocks, in order.
+class TrajectoryEncoder {
+public:
+    explicit TrajectoryEncoder(const TrajectoryHeader& header) : layout(header), frame(0) {}
+
+    // Fills block (frameBytes(frame) bytes) from state and moves on.
+    void encode(const FlockState& state, char* block) {
+        std::size_t n = layout.getAgents();
+        char* p = copyColumn(state.x.data(), n, block);
+        p = copyColumn(state.y.data(), n, p);
+        p = copyColumn(state.orientation.data(), n, p);
+        p = copyColumn(state.rotation.data(), n, p);
+        if (layout.isKeyframe(frame)) {
+            p = copyColumn(state.vx.data(), n, p);
+            copyColumn(state.vy.data(), n, p);
+            vx.assign(state.vx.begin(), state.vx.end());
+            vy.assign(state.vy.begin(), state.vy.end());
+        } else {
+            float scaleX = deltaScale(state.vx, vx);
+            float scaleY = deltaScale(state.vy, vy);
+            std::memcpy(p, &scaleX, sizeof(float));
+            std::memcpy(p + sizeof(float), &scaleY, sizeof(float));
+            p += 2 * sizeof(float);
+            p = encodeDeltas(state.vx, scaleX, vx, p);
+            std::size_t padding = layout.deltaBytes() - static_cast<std::size_t>(p - block) - n * sizeof(std::int16_t);
+            p = encodeDeltas(state.vy, scaleY, vy, p);
+            std::memset(p, 0, padding);
+        }
+        ++frame;
+    }
+
+    std::size_t nextFrameBytes() const { return layout.frameBytes(frame); }
+
+private:
+    TrajectoryLayout layout;
+    std::uint64_t frame;
+    std::vector<float> vx, vy;  // velocities as the decoder will see them
+
+    static char* copyColumn(const float* column, std::size_t n, char* out) {
+        std::memcpy(out, column, n * sizeof(float));
+        return out + n * sizeof(float);
+    }
+
+    static float deltaScale(const std::vector<float>& current, const std::vector<float>& previous) {
+        float largest = 0.f;
+        for (std::size_t i = 0; i < current.size(); ++i)
+            largest = std::max(largest, std::abs(current[i] - previous[i]));
+        return largest / 32767.f;
+    }
+
+    static char* encodeDeltas(const std::vector<float>& current, float scale,
+                              std::vector<float>& previous, char* out) {
+        for (std::size_t i = 0; i < current.size(); ++i) {
+            std::int16_t q = 0;
+            if (scale > 0.f) {
+                long step = std::lround((current[i] - previous[i]) / scale);
+                q = static_cast<std::int16_t>(std::max(-32767L, std::min(32767L, step)));
+            }
+            previous[i] += static_cast<float>(q) * scale;
+            std::memcpy(out + i * sizeof(q), &q, sizeof(q));
+        }
+        return out + current.size() * sizeof(std::int16_t);
+    }
+};
+
+
+// Turns one frame block back into a flock state. A delta frame steps the
+// velocities already in state, so it must hold the previous frame.
+inline void decodeTrajectoryFrame(const TrajectoryLayout& layout, std::uint64_t frame,
+                                  const char* block, FlockState& state) {
+    std::size_t n = layout.getAgents();
+    state.resize(n);
+    const std::size_t column = n * sizeof(float);
+    std::memcpy(state.x.data(), block, column);
+    std::memcpy(state.y.data(), block + column, column);
+    std::memcpy(state.orientation.data(), block + 2 * column, column);
+    std::memcpy(state.rotation.data(), block + 3 * column, column);
+    const char* p = block + 4 * column;
+    if (layout.isKeyframe(frame)) {
+        std::memcpy(state.vx.data(), p, column);
+        std::memcpy(state.vy.data(), p + column, column);
+        return;
+    }
+    float scaleX, scaleY;
+    std::memcpy(&scaleX, p, sizeof(float));
+    std::memcpy(&scaleY, p + sizeof(float), sizeof(float));
+    const char* deltasX = p + 2 * sizeof(float);
+    const char* deltasY = deltasX + n * sizeof(std::int16_t);
+    for (std::size_t i = 0; i < n; ++i) {
+        std::int16_t qx, qy;
+        std::memcpy(&qx, deltasX + i * sizeof(qx), sizeof(qx));
+        std::memcpy(&qy, deltasY + i * sizeof(qy), sizeof(qy));
+        state.vx[i] += static_cast<float>(qx) * scaleX;
+        state.vy[i] += static_cast<float>(qy) * scaleY;
+    }
+}
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef TRAJECTORY_PLAYER_HPP
+#define TRAJECTORY_PLAYER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "FlockState.hpp"
+#include "TrajectoryFormat.hpp"
+
+
+// Read-only view of a trajectory file (see TrajectoryFormat.hpp) through
+// mmap. frame() points straight into the mapped pages: the position and
+// orientation columns are stored the same way in every block, so drawing
+// needs no decoding even when velocities are delta-compressed.
+//
+// Only a window of frames around the one last asked for stays advised:
+// the next readAhead frames are requested from the kernel ahead of time and
+// frames that fall more than keepBehind behind the window are dropped with
+// MADV_DONTNEED, so a multi-GB recording costs a few frames of memory.
+class TrajectoryPlayer {
+public:
+    explicit TrajectoryPlayer(const char* path, std::uint64_t readAhead = 8, std::uint64_t keepBehind = 2)
+        : base(nullptr), mappedBytes(0), header(), layout(header), frames(0),
+          readAhead(readAhead), keepBehind(keepBehind), windowBegin(0), windowEnd(0), decoded(noFrame)
+    {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && static_cast<std::uint64_t>(info.st_size) >= sizeof(TrajectoryHeader)) {
+            mappedBytes = static_cast<std::size_t>(info.st_size);
+            void* mapped = ::mmap(nullptr, mappedBytes, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapped != MAP_FAILED)
+                base = static_cast<const char*>(mapped);
+        }
+        ::close(fd);  // the mapping keeps the file open
+        if (!base)
+            return;
+        std::memcpy(&header, base, sizeof(header));
+        if (!header.valid()) {
+            unmap();
+            return;
+        }
+        layout = TrajectoryLayout(header);
+        // A recorder that did not finish leaves frames at 0; trust the size.
+        frames = std::min<std::uint64_t>(layout.framesIn(mappedBytes - sizeof(header)),
+                                         header.frames > 0 ? header.frames : ~0ull);
+        if (frames == 0) {
+            unmap();
+            return;
+        }
+        ::madvise(const_cast<char*>(base), mappedBytes, MADV_RANDOM);
+    }
+
+    ~TrajectoryPlayer() { unmap(); }
+
+    TrajectoryPlayer(const TrajectoryPlayer&) = delete;
+    TrajectoryPlayer& operator=(const TrajectoryPlayer&) = delete;
+
+    bool isOpen() const { return base != nullptr; }
+    const TrajectoryHeader& getHeader() const { return header; }
+    // At least 1: a file without a whole frame does not open.
+    std::uint64_t frameCount() const { return frames; }
+
+    // Positions and orientations of frame, valid while the player lives.
+    FlockColumns frame(std::uint64_t index) {
+        index = std::min(index, frames - 1);
+        moveWindow(index);
+        const float* column = reinterpret_cast<const float*>(block(index));
+        std::size_t n = layout.getAgents();
+        return FlockColumns{ column, column + n, column + 2 * n, n };
+    }
+
+    // The whole state of frame, velocities included, valid until the next
+    // call. Stepping forward decodes one block per frame; anything else
+    // decodes from the keyframe before index.
+    const FlockState& decode(std::uint64_t index) {
+        index = std::min(index, frames - 1);
+        moveWindow(index);
+        std::uint64_t from = index - index % layout.getKeyframeInterval();
+        if (decoded != noFrame && decoded <= index && decoded >= from)
+            from = decoded + 1;
+        for (std::uint64_t f = from; f <= index; ++f)
+            decodeTrajectoryFrame(layout, f, block(f), state);
+        decoded = index;
+        return state;
+    }
+
+private:
+    static const std::uint64_t noFrame = ~0ull;
+
+    const char* base;
+    std::size_t mappedBytes;
+    TrajectoryHeader header;
+    TrajectoryLayout layout;
+    std::uint64_t frames;
+    std::uint64_t readAhead;
+    std::uint64_t keepBehind;
+    std::uint64_t windowBegin, windowEnd;  // frames currently advised WILLNEED
+    std::uint64_t decoded;                 // frame held in state
+    FlockState state;
+
+    const char* block(std::uint64_t index) const {
+        return base + sizeof(TrajectoryHeader) + layout.offset(index);
+    }
+
+    // Byte range of frames [first, last), clamped to the file.
+    void range(std::uint64_t first, std::uint64_t last, std::size_t& begin, std::size_t& end) const {
+        begin = static_cast<std::size_t>(block(first) - base);
+        end = last >= frames ? mappedBytes : static_cast<std::size_t>(block(last) - base);
+    }
+
+    void advise(std::uint64_t first, std::uint64_t last, int advice) {
+        if (first >= last)
+            return;
+        const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        std::size_t begin, end;
+        range(first, last, begin, end);
+        if (advice == MADV_DONTNEED) {
+            // Only whole pages of these frames; neighbors may share the edges.
+            begin = (begin + page - 1) / page * page;
+            end = end / page * page;
+        } else {
+            begin = begin / page * page;
+        }
+        if (begin < end)
+            ::madvise(const_cast<char*>(base) + begin, end - begin, advice);
+    }
+
+    void moveWindow(std::uint64_t index) {
+        // Stay put while index is in the first half of the read-ahead, so
+        // the window moves in steps instead of on every frame.
+        bool ahead = index + readAhead / 2 < windowEnd || windowEnd == frames;
+        if (index >= windowBegin && index < windowEnd && ahead)
+            return;
+        std::uint64_t begin = index > keepBehind ? index - keepBehind : 0;
+        std::uint64_t end = std::min(frames, index + readAhead + 1);
+        // Drop what leaves the window, then ask for what enters it.
+        advise(windowBegin, std::min(windowEnd, begin), MADV_DONTNEED);
+        advise(std::max(windowBegin, end), windowEnd, MADV_DONTNEED);
+        advise(begin, std::min(end, windowBegin), MADV_WILLNEED);
+        advise(std::max(begin, windowEnd), end, MADV_WILLNEED);
+        windowBegin = begin;
+        windowEnd = end;
+    }
+
+    void unmap() {
+        if (base)
+            ::munmap(const_cast<char*>(base), mappedBytes);
+        base = nullptr;
+        frames = 0;
+    }
+};
+
+#endif
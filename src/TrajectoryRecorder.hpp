@@ -0,0 +1,125 @@
+#ifndef TRAJECTORY_RECORDER_HPP
+#define TRAJECTORY_RECORDER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FlockState.hpp"
+#include "FramePipeline.hpp"
+#include "TrajectoryFormat.hpp"
+
+
+// Appends one frame of flock state per record() call to a trajectory file
+// (see TrajectoryFormat.hpp). record() only copies the state into one of a
+// few buffers; a writer thread encodes the frame blocks and writes them
+// with large buffered writes. The caller blocks only when the writer has
+// fallen a whole pipeline behind.
+class TrajectoryRecorder {
+public:
+    struct Options {
+        bool velocityDeltas = false;
+        std::uint32_t keyframeInterval = 60;  // with velocity deltas
+        std::size_t pipelineDepth = 4;
+        std::size_t bufferBytes = 8u << 20;
+    };
+
+    // Check isOpen() afterwards.
+    TrajectoryRecorder(const char* path, TrajectoryHeader header, const Options& options)
+        : header(header), pipeline(options.pipelineDepth), file(std::fopen(path, "wb")),
+          recorded(0), recordNs(0)
+    {
+        if (options.velocityDeltas) {
+            this->header.flags |= TrajectoryHeader::VelocityDeltas;
+            this->header.keyframeInterval = options.keyframeInterval > 0 ? options.keyframeInterval : 1;
+        }
+        if (!file)
+            return;
+        std::setvbuf(file, nullptr, _IOFBF, options.bufferBytes);
+        std::fwrite(&this->header, sizeof(this->header), 1, file);
+        writer = std::thread([this] { writeLoop(); });
+    }
+
+    // Waits for every recorded frame to reach the file, then fills in the
+    // frame count.
+    ~TrajectoryRecorder() {
+        if (!file)
+            return;
+        pipeline.close();
+        writer.join();
+        header.frames = recorded;
+        std::fseek(file, 0, SEEK_SET);
+        std::fwrite(&header, sizeof(header), 1, file);
+        std::fclose(file);
+    }
+
+    TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+    TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+
+    // state must have header.agents agents.
+    void record(const FlockState& state) {
+        if (!file)
+            return;
+        auto start = std::chrono::steady_clock::now();
+        FlockState* frame = pipeline.acquire();
+        *frame = state;  // reuses the buffer's capacity after the first lap
+        pipeline.publish(frame);
+        ++recorded;
+        recordNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Records agent k from state[order[k]], for simulations that reorder
+    // their agents; the file keeps every agent in the same place.
+    void record(const FlockState& state, const std::vector<std::uint32_t>& order) {
+        if (!file)
+            return;
+        auto start = std::chrono::steady_clock::now();
+        FlockState* frame = pipeline.acquire();
+        frame->gather(state, order);
+        pipeline.publish(frame);
+        ++recorded;
+        recordNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::uint64_t getFrames() const { return recorded; }
+    // Time the recording thread spent in record().
+    double getRecordSeconds() const { return recordNs * 1e-9; }
+    const TrajectoryHeader& getHeader() const { return header; }
+
+private:
+    TrajectoryHeader header;
+    FramePipeline<FlockState> pipeline;
+    std::FILE* file;
+    std::thread writer;
+    std::uint64_t recorded;
+    std::int64_t recordNs;
+
+    void writeLoop() {
+        TrajectoryEncoder encoder(header);
+        std::vector<char> block;
+        while (FlockState* frame = pipeline.consume()) {
+            block.resize(encoder.nextFrameBytes());
+            encoder.encode(*frame, block.data());
+            pipeline.release(frame);
+            std::fwrite(block.data(), 1, block.size(), file);
+        }
+    }
+};
+
+// Summary line for a finished recording; stepSeconds is the time spent
+// stepping the simulation, to put the recording cost in proportion.
+inline void reportRecording(const TrajectoryRecorder& recorder, const char* path, double stepSeconds) {
+    double seconds = recorder.getRecordSeconds();
+    std::printf("  recorded:   %llu frames to %s (%s), %.2f%% of step time in record()\n",
+                static_cast<unsigned long long>(recorder.getFrames()), path,
+                recorder.getHeader().velocityDeltas() ? "velocity deltas" : "raw",
+                stepSeconds > 0.0 ? 100.0 * seconds / stepSeconds : 0.0);
+}
+
+#endif
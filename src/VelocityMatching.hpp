@@ -58,4 +58,55 @@ public:
                                        float deltaTime) override;
 };
 
+
+// PositionMatching
+
+inline SteeringOutput PositionMatching::getSteering(const Kinematic& character, const Kinematic& target, float deltaTime) {
+    SteeringOutput output;
+    // Compute desired velocity to reach target position in deltaTime
+    sf::Vector2f desiredVelocity = (target.position - character.position) / deltaTime;
+    // The linear acceleration needed is the difference between desired and current velocity
+    output.linear = desiredVelocity - character.velocity;
+    output.angular = 0.f;
+    return output;
+}
+
+
+// OrientationMatching
+
+inline SteeringOutput OrientationMatching::getSteering(const Kinematic& character, const Kinematic& target, float deltaTime) {
+    SteeringOutput output;
+    // Compute smallest angular difference
+    float diff = target.orientation - character.orientation;
+    while (diff > 3.14159f) diff -= 2.f * 3.14159f;
+    while (diff < -3.14159f) diff += 2.f * 3.14159f;
+    // Desired angular velocity to cover the difference in deltaTime
+    float desiredAngularVelocity = diff / deltaTime;
+    output.linear = sf::Vector2f(0.f, 0.f);
+    output.angular = desiredAngularVelocity - character.rotation;
+    return output;
+}
+
+//  VelocityMatching
+
+inline SteeringOutput VelocityMatching::getSteering(const Kinematic& character, const Kinematic& target, float deltaTime) {
+    SteeringOutput output;
+    
+    const float timeToTarget = 1.0f;  
+    output.linear = (target.velocity - character.velocity) / timeToTarget;
+    output.angular = 0.f;
+    return output;
+}
+
+
+// RotationMatching
+
+inline SteeringOutput RotationMatching::getSteering(const Kinematic& character, const Kinematic& target, float deltaTime) {
+    SteeringOutput output;
+
+    output.linear = sf::Vector2f(0.f, 0.f);
+    output.angular = (target.rotation - character.rotation) / deltaTime;
+    return output;
+}
+
 #endif 
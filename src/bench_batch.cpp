@@ -0,0 +1,121 @@
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+#include "FlockBatch.hpp"
+
+// Multi-world throughput: many small independent flocks stepped as one
+// FlockBatch, against the same worlds as one FlockSimulation each stepped in
+// turn (what running them one after another would cost). Reports ns per
+// agent-update for both as CSV and checks that every world of the batch
+// ends exactly where its own simulation does.
+//
+//   ./bench_batch [--worlds N] [--boids N] [--frames N] [--threads N] [--seed N]
+
+struct WorldSpawn {
+    float width, height;
+    unsigned seed;
+    std::vector<Kinematic> boids;
+};
+
+// World w's window is 480..800 px wide and 360..600 px high.
+static std::vector<WorldSpawn> spawnWorlds(int worlds, int boids, float maxSpeed, unsigned seed) {
+    std::vector<WorldSpawn> spawns(worlds);
+    for (int w = 0; w < worlds; ++w) {
+        std::mt19937 rng(seed * 7919u + static_cast<unsigned>(w));
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+        WorldSpawn& spawn = spawns[w];
+        spawn.width = 480.f + 320.f * unit(rng);
+        spawn.height = 360.f + 240.f * unit(rng);
+        spawn.seed = seed + static_cast<unsigned>(w);
+        for (int i = 0; i < boids; ++i) {
+            Kinematic k;
+            k.position = sf::Vector2f(spawn.width * unit(rng), spawn.height * unit(rng));
+            k.orientation = 2.f * PI * unit(rng);
+            k.velocity = sf::Vector2f(std::cos(k.orientation), std::sin(k.orientation)) * maxSpeed;
+            k.rotation = 0.f;
+            spawn.boids.push_back(k);
+        }
+    }
+    return spawns;
+}
+
+static double elapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    int worlds = 4096;
+    int boids = 100;
+    int frames = 100;
+    int threads = 0;
+    unsigned seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--worlds") == 0) worlds = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--boids") == 0) boids = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--frames") == 0) frames = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--threads") == 0) threads = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--seed") == 0) seed = static_cast<unsigned>(std::atoi(argv[i + 1]));
+    }
+
+    FlockParams params;
+    params.useSpatialGrid = false;
+    params.useNeighborList = false;
+    const float dt = 1.f / 60.f;
+    const double updates = static_cast<double>(worlds) * boids * frames;
+    std::vector<WorldSpawn> spawns = spawnWorlds(worlds, boids, params.maxSpeed, seed);
+
+    FlockBatch batch(params, threads);
+    for (const WorldSpawn& spawn : spawns) {
+        batch.addWorld(spawn.seed, spawn.width, spawn.height);
+        for (const Kinematic& k : spawn.boids)
+            batch.addBoid(k);
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f)
+        batch.step(dt);
+    double batchNs = elapsedNs(start);
+
+    // One simulation per world, single-threaded each, stepped in turn.
+    std::vector<std::unique_ptr<FlockSimulation>> separate;
+    for (const WorldSpawn& spawn : spawns) {
+        FlockParams world = params;
+        world.worldWidth = spawn.width;
+        world.worldHeight = spawn.height;
+        separate.emplace_back(new FlockSimulation(world, 1));
+        for (const Kinematic& k : spawn.boids)
+            separate.back()->addBoid(k, spawn.seed);
+    }
+    start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f)
+        for (std::unique_ptr<FlockSimulation>& simulation : separate)
+            simulation->step(dt);
+    double separateNs = elapsedNs(start);
+
+    int mismatched = 0;
+    for (std::size_t w = 0; w < batch.worldCount(); ++w) {
+        const FlockState& own = separate[w]->state();
+        const FlockState& all = batch.state();
+        std::size_t base = batch.worldBegin(w);
+        for (std::size_t i = 0; i < own.size(); ++i)
+            if (own.x[i] != all.x[base + i] || own.y[i] != all.y[base + i] ||
+                own.vx[i] != all.vx[base + i] || own.vy[i] != all.vy[base + i] ||
+                own.orientation[i] != all.orientation[base + i]) {
+                mismatched++;
+                break;
+            }
+    }
+
+    std::printf("mode,worlds,boids_per_world,frames,threads,ns_per_update,seconds\n");
+    std::printf("batch,%d,%d,%d,%d,%.2f,%.3f\n", worlds, boids, frames, batch.getThreadCount(),
+                batchNs / updates, batchNs * 1e-9);
+    std::printf("separate,%d,%d,%d,1,%.2f,%.3f\n", worlds, boids, frames, separateNs / updates, separateNs * 1e-9);
+    std::fprintf(stderr, "%d of %d worlds differ from their own simulation\n", mismatched, worlds);
+    return mismatched == 0 ? 0 : 1;
+}
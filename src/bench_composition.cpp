@@ -0,0 +1,155 @@
+#include <SFML/Graphics.hpp>
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "Steering.hpp"
+#include "FlockState.hpp"
+#include "FlockKernel.hpp"
+#include "SteeringComposition.hpp"
+#include "MicroBench.hpp"
+
+// Virtual versus static dispatch in a per-agent loop: every agent owns its
+// behaviors and the loop steers agent i % agents on call i. The same
+// behaviors, parameters and Kinematic pairs are used in every variant of a
+// case.
+//
+//   ./bench_composition [--calls N] [--agents N]
+
+static ArriveBehavior makeArrive() { return ArriveBehavior(300.f, 250.f, 5.f, 200.f, 0.05f); }
+static AlignBehavior makeAlign() { return AlignBehavior(18.f, PI, 0.05f, 0.5f, 0.1f); }
+static WanderBehavior makeWander(unsigned i) {
+    WanderBehavior wander(5.f, 7.f, 10.f, 15.f, 1.f, 0.1f);
+    wander.seed(1, i);
+    return wander;
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t calls = 4000000;
+    std::size_t agents = 4096;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--calls") == 0)
+            calls = static_cast<std::size_t>(std::atof(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--agents") == 0)
+            agents = static_cast<std::size_t>(std::atoi(argv[i + 1]));
+    }
+
+    std::vector<Kinematic> characters = randomKinematics<Kinematic>(agents, 1);
+    std::vector<Kinematic> targets = randomKinematics<Kinematic>(agents, 2);
+    const float dt = 1.f / 60.f;
+
+    printBenchHeader();
+
+    // Arrive + Align per agent, as in part2.
+    {
+        std::vector<std::unique_ptr<SteeringBehavior>> arrives, aligns;
+        std::vector<Blend<ArriveBehavior, AlignBehavior>> blends;
+        for (std::size_t i = 0; i < agents; ++i) {
+            arrives.emplace_back(new ArriveBehavior(makeArrive()));
+            aligns.emplace_back(new AlignBehavior(makeAlign()));
+            blends.push_back(Blend<ArriveBehavior, AlignBehavior>({ 1.f, 1.f }, makeArrive(), makeAlign()));
+        }
+        printBenchResult(measureCalls("arrive+align: 2 virtual calls", calls, [&](std::size_t i) {
+            std::size_t k = i % agents;
+            SteeringOutput a = arrives[k]->getSteering(characters[k], targets[k], dt);
+            SteeringOutput b = aligns[k]->getSteering(characters[k], targets[k], dt);
+            return a.linear.x + b.angular;
+        }));
+        printBenchResult(measureCalls("arrive+align: Blend<Arrive, Align>", calls, [&](std::size_t i) {
+            std::size_t k = i % agents;
+            SteeringOutput out = blends[k].steer(characters[k], targets[k], dt);
+            return out.linear.x + out.angular;
+        }));
+    }
+
+    // Wander per agent, as in part3.
+    {
+        std::vector<std::unique_ptr<SteeringBehavior>> virtuals;
+        std::vector<WanderBehavior> statics;
+        for (std::size_t i = 0; i < agents; ++i) {
+            virtuals.emplace_back(new WanderBehavior(makeWander(static_cast<unsigned>(i))));
+            statics.push_back(makeWander(static_cast<unsigned>(i)));
+        }
+        printBenchResult(measureCalls("wander: virtual getSteering", calls, [&](std::size_t i) {
+            std::size_t k = i % agents;
+            SteeringOutput out = virtuals[k]->getSteering(characters[k], characters[k], dt);
+            return out.linear.x;
+        }));
+        printBenchResult(measureCalls("wander: static steer", calls, [&](std::size_t i) {
+            std::size_t k = i % agents;
+            SteeringOutput out = statics[k].steer(characters[k], characters[k], dt);
+            return out.linear.x;
+        }));
+    }
+
+    // Agents of three kinds interleaved in one array.
+    {
+        std::vector<std::unique_ptr<SteeringBehavior>> virtuals;
+        std::vector<AnyBehavior> variants;
+        for (std::size_t i = 0; i < agents; ++i) {
+            switch (i % 3) {
+            case 0:
+                virtuals.emplace_back(new ArriveBehavior(makeArrive()));
+                variants.push_back(makeArrive());
+                break;
+            case 1:
+                virtuals.emplace_back(new AlignBehavior(makeAlign()));
+                variants.push_back(makeAlign());
+                break;
+            default:
+                virtuals.emplace_back(new WanderBehavior(makeWander(static_cast<unsigned>(i))));
+                variants.push_back(makeWander(static_cast<unsigned>(i)));
+                break;
+            }
+        }
+        printBenchResult(measureCalls("mixed: unique_ptr<SteeringBehavior>", calls, [&](std::size_t i) {
+            std::size_t k = i % agents;
+            SteeringOutput out = virtuals[k]->getSteering(characters[k], targets[k], dt);
+            return out.linear.x + out.angular;
+        }));
+        printBenchResult(measureCalls("mixed: std::variant (AnyBehavior)", calls, [&](std::size_t i) {
+            std::size_t k = i % agents;
+            SteeringOutput out = steerAny(variants[k], characters[k], targets[k], dt);
+            return out.linear.x + out.angular;
+        }));
+    }
+
+    // Flock terms over a 256-boid neighborhood, as in part4: one pass that
+    // fills every sum against one scan of the flock per term. Calls are
+    // ~256x heavier here, so fewer are made.
+    {
+        typedef Blend<Separation, Alignment, Cohesion> FlockForce;
+        const std::size_t flockCalls = std::max<std::size_t>(1, calls / 256);
+        FlockState flock;
+        for (const Kinematic& k : randomKinematics<Kinematic>(256, 3))
+            flock.push_back(k);
+        FlockKernel kernel;
+        Priority<Limit<FlockForce>, When<NoNeighbors, OnKinematics<WanderBehavior>>> fused(0.f,
+            Limit<FlockForce>(5.f, FlockForce({ 2.f, 1.f, 1.f }, Separation(), Alignment(), Cohesion())),
+            When<NoNeighbors, OnKinematics<WanderBehavior>>(NoNeighbors(), OnKinematics<WanderBehavior>(makeWander(0))));
+        Separation separation;
+        Alignment alignment;
+        Cohesion cohesion;
+        printBenchResult(measureCalls("flock: Priority, one fused pass", flockCalls, [&](std::size_t i) {
+            const Kinematic& c = characters[i % agents];
+            FlockSums sums;
+            kernel.accumulateAll(flock, c.position, 100.f, 20.f, sums);
+            SteeringOutput out = fused.steer(SteeringContext{ c, c, dt, FlockNeighborhood{ c.position, sums } });
+            return out.linear.x;
+        }));
+        printBenchResult(measureCalls("flock: one scan per term", flockCalls, [&](std::size_t i) {
+            const Kinematic& c = characters[i % agents];
+            FlockSums a, b, d;
+            kernel.accumulateAll(flock, c.position, 100.f, 20.f, a);
+            kernel.accumulateAll(flock, c.position, 100.f, 20.f, b);
+            kernel.accumulateAll(flock, c.position, 100.f, 20.f, d);
+            sf::Vector2f linear = separation.steer(SteeringContext{ c, c, dt, FlockNeighborhood{ c.position, a } }).linear * 2.f
+                                + alignment.steer(SteeringContext{ c, c, dt, FlockNeighborhood{ c.position, b } }).linear
+                                + cohesion.steer(SteeringContext{ c, c, dt, FlockNeighborhood{ c.position, d } }).linear;
+            return clamp(linear, 5.f).x;
+        }));
+    }
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include <SFML/Graphics.hpp>
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "FlockSimulation.hpp"
+#include "PerfCounter.hpp"
+
+// Flock scaling benchmark: FlockingBehavior plus integration, headless, for
+// N = 1e2 .. 1e6 at a fixed density (part4b's by default). For every N it
+// reports ns per agent-update, cache misses per agent-update (perf counters,
+// n/a where unavailable), the distribution of neighbor counts and the
+// process peak RSS, as CSV or JSON on stdout. --sort N re-sorts the boids
+// into Morton order every N frames (see FlockSimulation::sortBoids).
+//
+//   ./bench_flocking [--format csv|json] [--max N] [--threads N]
+//                    [--density boids-per-pixel] [--seed N] [--sort N]
+
+struct BenchRow {
+    int agents;
+    int frames;
+    double nsPerUpdate;
+    double missesPerUpdate;  // < 0: no perf counters
+    double missRate;
+    double meanNeighbors;
+    int minNeighbors;
+    int p50Neighbors;
+    int p95Neighbors;
+    int p99Neighbors;
+    int maxNeighbors;
+    long peakRssKb;
+};
+
+static long peakRssKb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;  // bytes on macOS
+#else
+    return usage.ru_maxrss;         // kilobytes on Linux
+#endif
+}
+
+// Boids strictly inside neighborRadius of each boid, as FlockingBehavior counts them.
+static std::vector<int> neighborCounts(const FlockState& flock, float radius) {
+    SpatialGrid grid(radius);
+    grid.rebuild(flock.size(), flock.positions());
+    std::vector<int> counts(flock.size(), 0);
+    std::vector<int> candidates;
+    for (std::size_t i = 0; i < flock.size(); ++i) {
+        grid.query(flock.position(i), radius, candidates);
+        for (int j : candidates) {
+            float dx = flock.x[j] - flock.x[i];
+            float dy = flock.y[j] - flock.y[i];
+            float d = std::sqrt(dx * dx + dy * dy);
+            if (d < radius && d > 0.f)
+                counts[i]++;
+        }
+    }
+    return counts;
+}
+
+// A counter column: value, or "n/a" (CSV) / null (JSON) without perf counters.
+static void formatCounter(char* out, std::size_t size, double value, const char* format, bool json) {
+    if (value < 0.0)
+        std::snprintf(out, size, "%s", json ? "null" : "n/a");
+    else
+        std::snprintf(out, size, format, value);
+}
+
+static BenchRow runOne(int agents, float density, int threads, unsigned seed, int sortInterval) {
+    FlockParams params;
+    float side = std::sqrt(agents / density);
+    params.worldWidth = side;
+    params.worldHeight = side;
+    params.sortInterval = sortInterval;
+
+    // Before the simulation starts its threads, so they are counted too.
+    PerfCounter misses(PerfCounter::CacheMisses);
+    PerfCounter references(PerfCounter::CacheReferences);
+    FlockSimulation simulation(params, threads);
+    std::srand(seed);
+    for (int i = 0; i < agents; ++i) {
+        Kinematic k;
+        k.position = sf::Vector2f(side * std::rand() / RAND_MAX, side * std::rand() / RAND_MAX);
+        float angle = (std::rand() % 360) * (PI / 180.f);
+        k.velocity = sf::Vector2f(std::cos(angle), std::sin(angle)) * params.maxSpeed;
+        k.orientation = angle;
+        k.rotation = 0.f;
+        simulation.addBoid(k, seed);
+    }
+
+    // Enough frames for ~1e7 agent-updates, at least 3; one warm-up frame.
+    const float dt = 1.f / 60.f;
+    int frames = std::max(3, std::min(300, static_cast<int>(1e7 / agents)));
+    simulation.step(dt);
+    misses.start();
+    references.start();
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f)
+        simulation.step(dt);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    double missCount = static_cast<double>(misses.stop());
+    double referenceCount = static_cast<double>(references.stop());
+
+    std::vector<int> counts = neighborCounts(simulation.state(), params.neighborRadius);
+    std::sort(counts.begin(), counts.end());
+    auto percentile = [&](double p) {
+        return counts[std::min(counts.size() - 1, static_cast<std::size_t>(p * counts.size()))];
+    };
+    double total = 0.0;
+    for (int c : counts)
+        total += c;
+
+    BenchRow row;
+    row.agents = agents;
+    row.frames = frames;
+    row.nsPerUpdate = ns / (static_cast<double>(frames) * agents);
+    row.missesPerUpdate = misses.isAvailable() ? missCount / (static_cast<double>(frames) * agents) : -1.0;
+    row.missRate = referenceCount > 0.0 ? missCount / referenceCount : -1.0;
+    row.meanNeighbors = total / counts.size();
+    row.minNeighbors = counts.front();
+    row.p50Neighbors = percentile(0.50);
+    row.p95Neighbors = percentile(0.95);
+    row.p99Neighbors = percentile(0.99);
+    row.maxNeighbors = counts.back();
+    row.peakRssKb = peakRssKb();
+    return row;
+}
+
+int main(int argc, char** argv)
+{
+    std::string format = "csv";
+    int maxAgents = 1000000;
+    int threads = 0;
+    unsigned seed = 1;
+    int sortInterval = 0;
+    float density = 100.f / (640.f * 480.f);
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--format") == 0) format = argv[i + 1];
+        else if (std::strcmp(argv[i], "--max") == 0) maxAgents = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--threads") == 0) threads = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--density") == 0) density = static_cast<float>(std::atof(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--seed") == 0) seed = static_cast<unsigned>(std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--sort") == 0) sortInterval = std::atoi(argv[i + 1]);
+    }
+
+    bool json = (format == "json");
+    if (json)
+        std::printf("{\"density\": %g, \"simd\": \"%s\", \"sort_interval\": %d, \"runs\": [\n",
+                    density, simdLevelName(detectSimdLevel()), sortInterval);
+    else
+        std::printf("agents,frames,ns_per_update,cache_misses_per_update,cache_miss_rate,"
+                    "mean_neighbors,min_neighbors,p50_neighbors,"
+                    "p95_neighbors,p99_neighbors,max_neighbors,peak_rss_kb\n");
+
+    bool first = true;
+    for (int agents = 100; agents <= maxAgents; agents *= 10) {
+        BenchRow r = runOne(agents, density, threads, seed, sortInterval);
+        char misses[32], missRate[32];
+        formatCounter(misses, sizeof(misses), r.missesPerUpdate, "%.3f", json);
+        formatCounter(missRate, sizeof(missRate), r.missRate, "%.4f", json);
+        if (json) {
+            std::printf("%s  {\"agents\": %d, \"frames\": %d, \"ns_per_update\": %.2f, "
+                        "\"cache_misses_per_update\": %s, \"cache_miss_rate\": %s, "
+                        "\"neighbors\": {\"mean\": %.2f, \"min\": %d, \"p50\": %d, \"p95\": %d, "
+                        "\"p99\": %d, \"max\": %d}, \"peak_rss_kb\": %ld}",
+                        first ? "" : ",\n", r.agents, r.frames, r.nsPerUpdate, misses, missRate,
+                        r.meanNeighbors, r.minNeighbors, r.p50Neighbors, r.p95Neighbors, r.p99Neighbors,
+                        r.maxNeighbors, r.peakRssKb);
+        } else {
+            std::printf("%d,%d,%.2f,%s,%s,%.2f,%d,%d,%d,%d,%d,%ld\n", r.agents, r.frames, r.nsPerUpdate,
+                        misses, missRate, r.meanNeighbors, r.minNeighbors, r.p50Neighbors, r.p95Neighbors,
+                        r.p99Neighbors, r.maxNeighbors, r.peakRssKb);
+        }
+        std::fflush(stdout);
+        first = false;
+    }
+    if (json)
+        std::printf("\n]}\n");
+    return 0;
+}
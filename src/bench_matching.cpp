@@ -0,0 +1,56 @@
+#include <SFML/System.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "VelocityMatching.hpp"
+#include "MicroBench.hpp"
+
+// Microbenchmarks for the matching behaviors in VelocityMatching.hpp. That
+// header has its own Kinematic, so it cannot share a binary with
+// bench_steering. Same method: each behavior through an opaque
+// SteeringBehavior* (virtual) and as a qualified call (direct).
+//
+//   ./bench_matching [--calls N]
+
+static const std::size_t batchSize = 4096;  // pairs reused round-robin
+
+template<typename Behavior>
+static void benchBoth(const char* virtualName, const char* directName,
+                      const std::vector<Kinematic>& characters, const std::vector<Kinematic>& targets,
+                      std::size_t calls) {
+    const float dt = 1.f / 60.f;
+    Behavior behavior;
+    SteeringBehavior* base = opaque<SteeringBehavior>(&behavior);
+    printBenchResult(measureCalls(virtualName, calls, [&](std::size_t i) {
+        std::size_t k = i % batchSize;
+        SteeringOutput out = base->getSteering(characters[k], targets[k], dt);
+        return out.linear.x + out.angular;
+    }));
+    printBenchResult(measureCalls(directName, calls, [&](std::size_t i) {
+        std::size_t k = i % batchSize;
+        SteeringOutput out = behavior.Behavior::getSteering(characters[k], targets[k], dt);
+        return out.linear.x + out.angular;
+    }));
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t calls = 4000000;
+    for (int i = 1; i + 1 < argc; i += 2)
+        if (std::strcmp(argv[i], "--calls") == 0)
+            calls = static_cast<std::size_t>(std::atof(argv[i + 1]));
+
+    std::vector<Kinematic> characters = randomKinematics<Kinematic>(batchSize, 1);
+    std::vector<Kinematic> targets = randomKinematics<Kinematic>(batchSize, 2);
+
+    printBenchHeader();
+    benchBoth<PositionMatching>("PositionMatching (virtual)", "PositionMatching (direct)",
+                                characters, targets, calls);
+    benchBoth<OrientationMatching>("OrientationMatching (virtual)", "OrientationMatching (direct)",
+                                   characters, targets, calls);
+    benchBoth<VelocityMatching>("VelocityMatching (virtual)", "VelocityMatching (direct)",
+                                characters, targets, calls);
+    benchBoth<RotationMatching>("RotationMatching (virtual)", "RotationMatching (direct)",
+                                characters, targets, calls);
+    return 0;
+}
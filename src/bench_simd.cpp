@@ -0,0 +1,141 @@
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "FlockKernel.hpp"
+#include "NeighborList.hpp"
+
+// Times the flocking neighbor kernel at each SIMD level over the same flock,
+// both over the whole flock (the linear scan) and over Verlet neighbor lists.
+//   ./bench_simd [numBoids]
+
+const float neighborRadius   = 60.f;
+const float separationRadius = 40.f;
+const float boidsPerPixel    = 100.f / (640.f * 480.f);  // part4b density
+
+struct Result {
+    double nsPerAgent;
+    float maxDeviation;
+};
+
+// The sums of |term| over the boid's neighbors, the scale FlockKernel's
+// tolerance is stated against: re-associating a sum changes it by at most
+// a few ulp of this, however much the terms cancel.
+static FlockSums summedMagnitudes(const FlockState& flock, sf::Vector2f position) {
+    FlockSums sums;
+    for (std::size_t j = 0; j < flock.size(); ++j) {
+        float dx = flock.x[j] - position.x;
+        float dy = flock.y[j] - position.y;
+        float distance = std::sqrt(dx * dx + dy * dy);
+        if (distance < neighborRadius && distance > 0.f) {
+            sums.alignment += sf::Vector2f(std::abs(flock.vx[j]), std::abs(flock.vy[j]));
+            sums.cohesion += sf::Vector2f(std::abs(flock.x[j]), std::abs(flock.y[j]));
+            sums.count++;
+            if (distance < separationRadius)
+                sums.separation += sf::Vector2f(std::abs(dx) / distance, std::abs(dy) / distance);
+        }
+    }
+    return sums;
+}
+
+// Largest difference between a and b relative to the summed magnitudes.
+static float deviation(const FlockSums& a, const FlockSums& b, const FlockSums& magnitude) {
+    float worst = 0.f;
+    const sf::Vector2f pa[3] = { a.separation, a.alignment, a.cohesion };
+    const sf::Vector2f pb[3] = { b.separation, b.alignment, b.cohesion };
+    const sf::Vector2f pm[3] = { magnitude.separation, magnitude.alignment, magnitude.cohesion };
+    for (int k = 0; k < 3; ++k) {
+        float dx = std::abs(pa[k].x - pb[k].x), dy = std::abs(pa[k].y - pb[k].y);
+        worst = std::max(worst, pm[k].x > 0.f ? dx / pm[k].x : dx);
+        worst = std::max(worst, pm[k].y > 0.f ? dy / pm[k].y : dy);
+    }
+    if (a.count != b.count)
+        worst = INFINITY;
+    return worst;
+}
+
+template <typename Sweep>
+static Result run(const FlockState& flock, const std::vector<FlockSums>& reference,
+                  const std::vector<FlockSums>& magnitudes,
+                  std::vector<FlockSums>& out, int repeats, Sweep sweep) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r)
+        sweep(out);
+    auto stop = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+
+    Result result;
+    result.nsPerAgent = ns / (static_cast<double>(repeats) * flock.size());
+    result.maxDeviation = 0.f;
+    if (!reference.empty())
+        for (std::size_t i = 0; i < flock.size(); ++i)
+            result.maxDeviation = std::max(result.maxDeviation, deviation(reference[i], out[i], magnitudes[i]));
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int numBoids = (argc > 1) ? std::atoi(argv[1]) : 10000;
+    float side = std::sqrt(numBoids / boidsPerPixel);
+
+    std::srand(1);
+    FlockState flock;
+    for (int i = 0; i < numBoids; ++i) {
+        Kinematic k;
+        k.position = sf::Vector2f(side * std::rand() / RAND_MAX, side * std::rand() / RAND_MAX);
+        float angle = (std::rand() % 360) * (PI / 180.f);
+        k.velocity = sf::Vector2f(std::cos(angle), std::sin(angle)) * 13.f;
+        k.orientation = angle;
+        k.rotation = 0.f;
+        flock.push_back(k);
+    }
+    NeighborList neighbors(neighborRadius, 10.f);
+    neighbors.update(flock.size(), flock.positions());
+
+    SimdLevel best = detectSimdLevel();
+    std::vector<SimdLevel> levels = { SimdLevel::Scalar };
+    if (best != SimdLevel::Scalar) levels.push_back(SimdLevel::SSE2);
+    if (best == SimdLevel::AVX2) levels.push_back(SimdLevel::AVX2);
+
+    std::printf("N=%d, world %.0fx%.0f, best level %s\n", numBoids, side, side, simdLevelName(best));
+    std::printf("%-8s %-10s %12s %9s %14s\n", "level", "candidates", "ns/agent", "speedup", "max rel. dev");
+
+    std::vector<FlockSums> magnitudes(numBoids);
+    for (int i = 0; i < numBoids; ++i)
+        magnitudes[i] = summedMagnitudes(flock, flock.position(i));
+
+    std::vector<FlockSums> scalarAll, scalarList, out(numBoids);
+    double baseAll = 0.0, baseList = 0.0;
+    for (SimdLevel level : levels) {
+        FlockKernel kernel(level);
+        auto all = [&](std::vector<FlockSums>& sums) {
+            for (int i = 0; i < numBoids; ++i) {
+                sums[i] = FlockSums();
+                kernel.accumulateAll(flock, flock.position(i), neighborRadius, separationRadius, sums[i]);
+            }
+        };
+        auto list = [&](std::vector<FlockSums>& sums) {
+            for (int i = 0; i < numBoids; ++i) {
+                sums[i] = FlockSums();
+                const int* first = neighbors.begin(i);
+                kernel.accumulateIndexed(flock, first, neighbors.end(i) - first, flock.position(i),
+                                         neighborRadius, separationRadius, sums[i]);
+            }
+        };
+
+        int allRepeats = std::max(1, static_cast<int>(2e8 / (double(numBoids) * numBoids)));
+        Result a = run(flock, scalarAll, magnitudes, out, allRepeats, all);
+        if (level == SimdLevel::Scalar) { scalarAll = out; baseAll = a.nsPerAgent; }
+        std::printf("%-8s %-10s %12.1f %8.2fx %14.2e\n", simdLevelName(level), "all",
+                    a.nsPerAgent, baseAll / a.nsPerAgent, a.maxDeviation);
+
+        Result l = run(flock, scalarList, magnitudes, out, 200, list);
+        if (level == SimdLevel::Scalar) { scalarList = out; baseList = l.nsPerAgent; }
+        std::printf("%-8s %-10s %12.1f %8.2fx %14.2e\n", simdLevelName(level), "verlet",
+                    l.nsPerAgent, baseList / l.nsPerAgent, l.maxDeviation);
+    }
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <SFML/Graphics.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+#include "Steering.hpp"
+#include "FlockSimulation.hpp"
+#include "MicroBench.hpp"
+
+// Microbenchmarks for the SteeringBehavior subclasses in Steering.hpp (and
+// FlockingBehavior). Every behavior is timed twice over the same random
+// character/target pairs: through a SteeringBehavior* the compiler cannot
+// see through (virtual) and as a qualified call on the concrete type
+// (direct), so the difference is the cost of virtual dispatch. The wander
+// rows include the call to its ArriveBehavior member; the baselines show
+// what its random draws cost and what building an ArriveBehavior on every
+// call, as wander used to, cost.
+//
+//   ./bench_steering [--calls N]
+
+static const std::size_t batchSize = 4096;  // pairs reused round-robin
+
+template<typename Behavior>
+static void benchBoth(const char* virtualName, const char* directName, Behavior& behavior,
+                      const std::vector<Kinematic>& characters, const std::vector<Kinematic>& targets,
+                      std::size_t calls) {
+    const float dt = 1.f / 60.f;
+    SteeringBehavior* base = opaque<SteeringBehavior>(&behavior);
+    printBenchResult(measureCalls(virtualName, calls, [&](std::size_t i) {
+        std::size_t k = i % batchSize;
+        SteeringOutput out = base->getSteering(characters[k], targets[k], dt);
+        return out.linear.x + out.angular;
+    }));
+    printBenchResult(measureCalls(directName, calls, [&](std::size_t i) {
+        std::size_t k = i % batchSize;
+        SteeringOutput out = behavior.Behavior::getSteering(characters[k], targets[k], dt);
+        return out.linear.x + out.angular;
+    }));
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t calls = 4000000;
+    for (int i = 1; i + 1 < argc; i += 2)
+        if (std::strcmp(argv[i], "--calls") == 0)
+            calls = static_cast<std::size_t>(std::atof(argv[i + 1]));
+
+    std::vector<Kinematic> characters = randomKinematics<Kinematic>(batchSize, 1);
+    std::vector<Kinematic> targets = randomKinematics<Kinematic>(batchSize, 2);
+
+    // Arrive/Align as in part2b, wander and flocking as in part4b.
+    FlockParams params;
+    ArriveBehavior arrive(300.f, 250.f, 5.f, 200.f, 0.05f);
+    AlignBehavior align(18.f, PI, 0.05f, 0.5f, 0.1f);
+    WanderBehavior wander(params.wanderMaxAccel, params.wanderMaxSpeed, params.wanderOffset,
+                          params.wanderRadius, params.wanderRate, params.wanderTimeToTarget);
+    wander.seed(1);
+    VelocityMatchingBehavior velocityMatching(100.f, 0.5f);
+    RotationMatchingBehavior rotationMatching(5.f, 0.5f);
+
+    // A part4b-sized flock (100 boids in 640x480), scanned linearly.
+    FlockState flock;
+    for (const Kinematic& k : randomKinematics<Kinematic>(100, 3))
+        flock.push_back(k);
+    FlockingBehavior flocking(&flock, params.neighborRadius, params.separationRadius,
+                              params.separationWeight, params.alignmentWeight, params.cohesionWeight,
+                              params.maxAccel,
+                              params.wanderMaxAccel, params.wanderMaxSpeed, params.wanderOffset,
+                              params.wanderRadius, params.wanderRate, params.wanderTimeToTarget);
+    flocking.seedWander(1);
+
+    printBenchHeader();
+    benchBoth("ArriveBehavior (virtual)", "ArriveBehavior (direct)", arrive, characters, targets, calls);
+    benchBoth("AlignBehavior (virtual)", "AlignBehavior (direct)", align, characters, targets, calls);
+    benchBoth("WanderBehavior (virtual)", "WanderBehavior (direct)", wander, characters, targets, calls);
+    benchBoth("VelocityMatchingBehavior (virtual)", "VelocityMatchingBehavior (direct)",
+              velocityMatching, characters, targets, calls);
+    benchBoth("RotationMatchingBehavior (virtual)", "RotationMatchingBehavior (direct)",
+              rotationMatching, characters, targets, calls);
+    benchBoth("FlockingBehavior 100 (virtual)", "FlockingBehavior 100 (direct)",
+              flocking, characters, targets, calls / 50);
+
+    // Baselines: the random sources wander has used and uses now.
+    printBenchResult(measureCalls("baseline: 2x std::rand", calls, [](std::size_t) {
+        return static_cast<float>(std::rand()) / RAND_MAX - static_cast<float>(std::rand()) / RAND_MAX;
+    }));
+    std::minstd_rand rng(1);
+    printBenchResult(measureCalls("baseline: 2x std::minstd_rand", calls, [&](std::size_t) {
+        return static_cast<float>(rng()) / rng.max() - static_cast<float>(rng()) / rng.max();
+    }));
+    RandomStream stream(0, 1);
+    printBenchResult(measureCalls("baseline: RandomStream::binomial", calls, [&](std::size_t) {
+        return stream.binomial();
+    }));
+    // One frame's samples for a whole 1024-agent flock per call, reported per sample.
+    std::vector<float> samples(1024);
+    BenchResult batch = measureCalls("baseline: fillBinomial (per sample)", calls / samples.size(),
+                                     [&](std::size_t frame) {
+        fillBinomial(0, samples.size(), static_cast<std::uint32_t>(frame), 1, samples.data());
+        return samples[frame % samples.size()];
+    });
+    batch.callsPerSecond *= samples.size();
+    batch.nsPerCall /= samples.size();
+    batch.cyclesPerCall /= samples.size();
+    batch.allocationsPerCall /= samples.size();
+    printBenchResult(batch);
+    // Wander's old arrive, constructed on the stack for every call; wander
+    // now keeps one as a member, so compare with the ArriveBehavior (direct)
+    // row for what that saves.
+    printBenchResult(measureCalls("baseline: old per-call ArriveBehavior", calls, [&](std::size_t i) {
+        std::size_t k = i % batchSize;
+        ArriveBehavior fresh(params.wanderMaxAccel, params.wanderMaxSpeed, 5.f,
+                             params.wanderRadius, params.wanderTimeToTarget);
+        SteeringOutput out = fresh.getSteering(characters[k], targets[k], 0.f);
+        return out.linear.x + out.angular;
+    }));
+    return 0;
+}
@@ -2,191 +2,137 @@
 #define FLOCKING_WANDER_HPP
 
 #include <SFML/Graphics.hpp>
+#include <algorithm>
 #include <cmath>
-#include <cstdlib>
+#include <cstddef>
 #include <vector>
+#include "Steering.hpp"
+#include "FlockState.hpp"
+#include "SpatialGrid.hpp"
+#include "NeighborList.hpp"
+#include "FlockKernel.hpp"
+#include "SteeringComposition.hpp"
 
 
-const float PI = 3.14159265f;
-
-inline float vectorLength(const sf::Vector2f& v) {
-    return std::sqrt(v.x * v.x + v.y * v.y);
-}
-
-inline sf::Vector2f normalize(const sf::Vector2f& v) {
-    float len = vectorLength(v);
-    if (len != 0)
-        return sf::Vector2f(v.x / len, v.y / len);
-    return v;
-}
-
-inline sf::Vector2f clamp(const sf::Vector2f& v, float maxVal) {
-    float len = vectorLength(v);
-    if (len > maxVal && len > 0)
-        return normalize(v) * maxVal;
-    return v;
-}
-
-inline float clamp(float value, float maxVal) {
-    if (std::abs(value) > maxVal)
-        return (value > 0) ? maxVal : -maxVal;
-    return value;
-}
-
-inline float mapToRange(float angle) {
-    while (angle > PI) angle -= 2 * PI;
-    while (angle < -PI) angle += 2 * PI;
-    return angle;
-}
-
-
-
-struct Kinematic {
-    sf::Vector2f position;
-    sf::Vector2f velocity;
-    float orientation; // radians
-    float rotation;    // radians per second
-};
-
-struct SteeringOutput {
-    sf::Vector2f linear;
-    float angular;       // (radians per second^2)
-};
+// A priority pipeline: the weighted flock terms first and, only when no
+// neighbors were found, the wander behavior. A boid whose neighbors'
+// terms cancel out keeps the zero flock steering, as it always has.
+class FlockingBehavior : public SteeringBehavior {
+public:
+    FlockingBehavior(const FlockState* flock,
+                     float neighborRadius, float separationRadius,
+                     float separationWeight, float alignmentWeight, float cohesionWeight,
+                     float maxAcceleration,
+                     // Parameters for wander behavior:
+                     float wanderMaxAccel, float wanderMaxSpeed, float wanderOffset,
+                     float wanderRadius, float wanderRate, float wanderTimeToTarget)
+        : flock(flock), grid(nullptr), neighbors(nullptr), rangeBegin(0), rangeEnd(~std::size_t(0)),
+          neighborRadius(neighborRadius), separationRadius(separationRadius), lastNeighbors(0),
+          pipeline(0.f,
+                   Limit<FlockForce>(maxAcceleration,
+                                     FlockForce({ separationWeight, alignmentWeight, cohesionWeight },
+                                                Separation(), Alignment(), Cohesion())),
+                   Wander(NoNeighbors(),
+                          OnKinematics<WanderBehavior>(WanderBehavior(wanderMaxAccel, wanderMaxSpeed, wanderOffset,
+                                                                      wanderRadius, wanderRate, wanderTimeToTarget))))
+    {}
 
+    // Looks neighbors up in grid instead of scanning the whole flock. The grid
+    // must be rebuilt from the current flock before steering is computed; the
+    // result is then bit-identical to the linear scan. Pass nullptr to go back
+    // to the linear scan.
+    void setNeighborGrid(const SpatialGrid* neighborGrid) {
+        grid = neighborGrid;
+    }
 
+    // Filters the character's cached Verlet list instead; takes precedence
+    // over the grid. The list must be updated from the current flock before
+    // steering is computed and its radius must be at least neighborRadius.
+    void setNeighborList(const NeighborList* neighborList) {
+        neighbors = neighborList;
+    }
 
-class SteeringBehavior {
-public:
-    virtual ~SteeringBehavior() {}
-    virtual SteeringOutput getSteering(const Kinematic& character,
-                                       const Kinematic& target,
-                                       float deltaTime) = 0;
-};
+    // Limits the linear scan to agents [begin, end) of the flock, e.g. the
+    // boid's own world in a FlockBatch. The grid and neighbor list ignore it.
+    void setNeighborRange(std::size_t begin, std::size_t end) {
+        rangeBegin = begin;
+        rangeEnd = end;
+    }
 
+    void seedWander(unsigned value, unsigned stream = 0) {
+        wander().seed(value, stream);
+    }
 
+    // Neighbors found by the last getSteering.
+    int getNeighborCount() const { return lastNeighbors; }
 
-// Wanders by choosing a random target on a circle.
-class WanderBehavior : public SteeringBehavior {
-public:
-    WanderBehavior(float maxAccel, float maxSpeed,
-                   float wanderOffset, float wanderRadius,
-                   float wanderRate, float timeToTarget)
-        : maxAcceleration(maxAccel), maxSpeed(maxSpeed),
-          wanderOffset(wanderOffset), wanderRadius(wanderRadius),
-          wanderRate(wanderRate), timeToTarget(timeToTarget),
-          wanderOrientation(0.f)
-    {}
+    WanderState getWanderState() const { return wander().getState(); }
+    void setWanderState(const WanderState& state) { wander().setState(state); }
 
-    virtual SteeringOutput getSteering(const Kinematic& character,
-                                       const Kinematic&,
-                                       float /*deltaTime*/) override {
-        // taking a random binomial number to update wander
-        wanderOrientation += randomBinomial() * wanderRate;
-        float targetOrientation = character.orientation + wanderOrientation;
-        
-        // calculating center of the wander circle.
-        sf::Vector2f circleCenter = character.position + normalize(character.velocity) * wanderOffset;
-        // calculating point on the circle.
-        sf::Vector2f displacement(std::cos(targetOrientation), std::sin(targetOrientation));
-        displacement *= wanderRadius;
-        
-        // fixing the wander target.
-        sf::Vector2f wanderTarget = circleCenter + displacement;
-        
-        // Arriving towards wander target
-        sf::Vector2f direction = wanderTarget - character.position;
-        float distance = vectorLength(direction);
-        const float targetRadius = 5.f; 
-        const float slowRadius = wanderRadius;
-        if (distance < targetRadius) {
-            return SteeringOutput{ sf::Vector2f(0.f, 0.f), 0.f };
-        }
-        float targetSpeed = (distance > slowRadius) ? maxSpeed : maxSpeed * distance / slowRadius;
-        sf::Vector2f desiredVelocity = normalize(direction) * targetSpeed;
-        sf::Vector2f acceleration = (desiredVelocity - character.velocity) / timeToTarget;
-        acceleration = clamp(acceleration, maxAcceleration);
-        return SteeringOutput{ acceleration, 0.f };
+    // Scalar (the default) is bit-identical to the original loop; see
+    // FlockKernel for the tolerance of the SSE2/AVX2 levels.
+    void setSimdLevel(SimdLevel level) {
+        kernel = FlockKernel(level);
     }
 
-private:
-    float maxAcceleration;
-    float maxSpeed;
-    float wanderOffset;
-    float wanderRadius;
-    float wanderRate;
-    float timeToTarget;
-    float wanderOrientation;
-
-    // random binomial value between -1 and 1
-    float randomBinomial() {
-        return ((float)std::rand() / RAND_MAX) - ((float)std::rand() / RAND_MAX);
+    // Steering for agent index of the flock; this is the path the demos use
+    // and the only one that can use the neighbor list.
+    SteeringOutput getSteering(std::size_t index, float deltaTime) {
+        sf::Vector2f position = flock->position(index);
+        FlockSums acc;
+        if (neighbors && index < neighbors->size()) {
+            const int* first = neighbors->begin(index);
+            kernel.accumulateIndexed(*flock, first, neighbors->end(index) - first, position,
+                                     neighborRadius, separationRadius, acc);
+        } else {
+            gather(position, acc);
+        }
+        lastNeighbors = acc.count;
+        Kinematic character = flock->get(index);
+        return pipeline.steer(SteeringContext{ character, character, deltaTime, FlockNeighborhood{ position, acc } });
     }
-};
-
-
-// If no neighbors are found, it goes back to the wander behavior.
-class FlockingBehavior : public SteeringBehavior {
-public:
-    FlockingBehavior(const std::vector<Kinematic>* flock,
-                     float neighborRadius, float separationRadius,
-                     float separationWeight, float alignmentWeight, float cohesionWeight,
-                     float maxAcceleration,
-                     // Parameters for wander behavior:
-                     float wanderMaxAccel, float wanderMaxSpeed, float wanderOffset,
-                     float wanderRadius, float wanderRate, float wanderTimeToTarget)
-        : flock(flock), neighborRadius(neighborRadius), separationRadius(separationRadius),
-          separationWeight(separationWeight), alignmentWeight(alignmentWeight), cohesionWeight(cohesionWeight),
-          maxAcceleration(maxAcceleration),
-          wander(wanderMaxAccel, wanderMaxSpeed, wanderOffset, wanderRadius, wanderRate, wanderTimeToTarget)
-    {}
 
+    // character need not live in the flock; a boid at the character's exact
+    // position is never counted, which also skips the character itself.
     virtual SteeringOutput getSteering(const Kinematic& character,
                                        const Kinematic& ,
                                        float deltaTime) override {
-        sf::Vector2f separation(0.f, 0.f);
-        sf::Vector2f alignment(0.f, 0.f);
-        sf::Vector2f cohesion(0.f, 0.f);
-        int count = 0;
-        for (const auto& other : *flock) {
-            
-            if (&other == &character)
-                continue;
-            sf::Vector2f toOther = other.position - character.position;
-            float distance = vectorLength(toOther);
-            if (distance < neighborRadius && distance > 0.f) {
-                alignment += other.velocity;
-                cohesion += other.position;
-                count++;
-                if (distance < separationRadius) {
-                    separation += (character.position - other.position) / distance;
-                }
-            }
-        }
-        if (count == 0) {
-            // if no neighbours, wander
-            return wander.getSteering(character, character, deltaTime);
-        }
-        
-        alignment /= static_cast<float>(count);
-        cohesion = (cohesion / static_cast<float>(count)) - character.position;
-        
-        
-        sf::Vector2f force = separation * separationWeight +
-                             alignment * alignmentWeight +
-                             cohesion * cohesionWeight;
-        force = clamp(force, maxAcceleration);
-        return SteeringOutput{ force, 0.f };
+        FlockSums acc;
+        gather(character.position, acc);
+        lastNeighbors = acc.count;
+        return pipeline.steer(SteeringContext{ character, character, deltaTime,
+                                               FlockNeighborhood{ character.position, acc } });
     }
 
 private:
-    const std::vector<Kinematic>* flock;
+    typedef Blend<Separation, Alignment, Cohesion> FlockForce;
+    typedef When<NoNeighbors, OnKinematics<WanderBehavior>> Wander;
+    typedef Priority<Limit<FlockForce>, Wander> Pipeline;
+
+    const FlockState* flock;
+    const SpatialGrid* grid;
+    const NeighborList* neighbors;
+    std::size_t rangeBegin, rangeEnd;  // of the linear scan
+    std::vector<int> candidates;  // scratch for grid queries
     float neighborRadius;
     float separationRadius;
-    float separationWeight;
-    float alignmentWeight;
-    float cohesionWeight;
-    float maxAcceleration;
-    WanderBehavior wander;
+    int lastNeighbors;
+    Pipeline pipeline;
+    FlockKernel kernel;
+
+    WanderBehavior& wander() { return pipeline.get<1>().get().get(); }
+    const WanderBehavior& wander() const { return pipeline.get<1>().get().get(); }
+
+    void gather(const sf::Vector2f& position, FlockSums& acc) {
+        if (grid) {
+            grid->query(position, neighborRadius, candidates);
+            kernel.accumulateIndexed(*flock, candidates.data(), candidates.size(), position,
+                                     neighborRadius, separationRadius, acc);
+        } else {
+            kernel.accumulateRange(*flock, rangeBegin, std::min(rangeEnd, flock->size()), position,
+                                   neighborRadius, separationRadius, acc);
+        }
+    }
 };
 
-#endif 
+#endif
@@ -1,62 +1,93 @@
 #include "VelocityMatching.hpp"
+#include "DemoOptions.hpp"
+#include "FixedTimestep.hpp"
 #include <SFML/Graphics.hpp>
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <vector>
 
 
-// PositionMatching
+// Velocity and Orientation Matching 
 
-SteeringOutput PositionMatching::getSteering(const Kinematic& character, const Kinematic& target, float deltaTime) {
-    SteeringOutput output;
-    // Compute desired velocity to reach target position in deltaTime
-    sf::Vector2f desiredVelocity = (target.position - character.position) / deltaTime;
-    // The linear acceleration needed is the difference between desired and current velocity
-    output.linear = desiredVelocity - character.velocity;
-    output.angular = 0.f;
-    return output;
+// Creating a target kinematic based on mouse data.
+Kinematic mouseTarget(const sf::Vector2f& mousePos, const sf::Vector2f& mouseVelocity) {
+    Kinematic target;
+    target.position = mousePos;  
+    target.velocity = mouseVelocity;
+    target.orientation = 0.f;
+    target.rotation = 0.f;
+    return target;
 }
 
+void updateCharacter(Kinematic& character, const Kinematic& target,
+                     VelocityMatching& velocityMatching, float deltaTime) {
+    // steering output from velocity matching
+    SteeringOutput steering = velocityMatching.getSteering(character, target, deltaTime);
 
-// OrientationMatching
+    // Updating the character's state
+    character.velocity += steering.linear * deltaTime;
+    character.position += character.velocity * deltaTime;
 
-SteeringOutput OrientationMatching::getSteering(const Kinematic& character, const Kinematic& target, float deltaTime) {
-    SteeringOutput output;
-    // Compute smallest angular difference
-    float diff = target.orientation - character.orientation;
-    while (diff > 3.14159f) diff -= 2.f * 3.14159f;
-    while (diff < -3.14159f) diff += 2.f * 3.14159f;
-    // Desired angular velocity to cover the difference in deltaTime
-    float desiredAngularVelocity = diff / deltaTime;
-    output.linear = sf::Vector2f(0.f, 0.f);
-    output.angular = desiredAngularVelocity - character.rotation;
-    return output;
+    // Updating orientation 
+    if (std::abs(character.velocity.x) > 0.01f || std::abs(character.velocity.y) > 0.01f) {
+        character.orientation = std::atan2(character.velocity.y, character.velocity.x);
+    }
 }
 
-//  VelocityMatching
-
-SteeringOutput VelocityMatching::getSteering(const Kinematic& character, const Kinematic& target, float deltaTime) {
-    SteeringOutput output;
-    
-    const float timeToTarget = 1.0f;  
-    output.linear = (target.velocity - character.velocity) / timeToTarget;
-    output.angular = 0.f;
-    return output;
+Kinematic startingCharacter() {
+    Kinematic character;
+    character.position = sf::Vector2f(400.f, 300.f);
+    character.velocity = sf::Vector2f(0.f, 0.f);
+    character.orientation = 0.f;
+    character.rotation = 0.f;
+    return character;
 }
 
+// Steps the characters without a window or texture; see DemoOptions.hpp.
+// Each character follows its own synthetic mouse circling the window center.
+int runHeadless(const DemoOptions& options) {
+    std::srand(options.seed);
+    const int numCharacters = options.boidsOr(1);
+    const sf::Vector2f center(320.f, 240.f);
+
+    std::vector<Kinematic> characters(numCharacters, startingCharacter());
+    std::vector<float> radius(numCharacters), speed(numCharacters), phase(numCharacters);
+    std::vector<sf::Vector2f> previousMousePos(numCharacters);
+    for (int i = 0; i < numCharacters; i++) {
+        radius[i] = 50.f + std::rand() % 150;
+        speed[i] = 0.5f + (std::rand() % 100) / 50.f;  // radians per second
+        phase[i] = (std::rand() % 360) * 3.14159f / 180.f;
+        previousMousePos[i] = center + sf::Vector2f(std::cos(phase[i]), std::sin(phase[i])) * radius[i];
+    }
 
-// RotationMatching
-
-SteeringOutput RotationMatching::getSteering(const Kinematic& character, const Kinematic& target, float deltaTime) {
-    SteeringOutput output;
+    VelocityMatching velocityMatching;
+    HeadlessTimer timer;
+    for (int frame = 0; frame < options.frames; frame++) {
+        float time = (frame + 1) * options.dt;
+        for (int i = 0; i < numCharacters; i++) {
+            float angle = phase[i] + speed[i] * time;
+            sf::Vector2f currentMousePos = center + sf::Vector2f(std::cos(angle), std::sin(angle)) * radius[i];
+            sf::Vector2f mouseVelocity = (currentMousePos - previousMousePos[i]) / options.dt;
+            previousMousePos[i] = currentMousePos;
+            updateCharacter(characters[i], mouseTarget(currentMousePos, mouseVelocity),
+                            velocityMatching, options.dt);
+        }
+    }
+    double seconds = timer.seconds();
 
-    output.linear = sf::Vector2f(0.f, 0.f);
-    output.angular = (target.rotation - character.rotation) / deltaTime;
-    return output;
+    StateChecksum checksum;
+    for (const auto& character : characters)
+        checksum.addKinematic(character);
+    reportHeadless("Part 1", options, numCharacters, seconds, checksum.value());
+    return 0;
 }
 
-// Velocity and Orientation Matching 
+int main(int argc, char** argv) {
+    DemoOptions options = parseDemoOptions(argc, argv);
+    if (options.headless)
+        return runHeadless(options);
 
-int main() {
     // Create the SFML window
     sf::RenderWindow window(sf::VideoMode(640, 480), "Part 1");
     window.setFramerateLimit(60);
@@ -76,16 +107,14 @@ int main() {
     boidSprite.setScale(4.f, 4.f);
 
     // Initializing character's kinematic state
-    Kinematic character;
-    character.position = sf::Vector2f(400.f, 300.f);
-    character.velocity = sf::Vector2f(0.f, 0.f);
-    character.orientation = 0.f;
-    character.rotation = 0.f;
+    Kinematic character = startingCharacter();
 
     VelocityMatching velocityMatching;
 
     // to computing mouse pointer velocity
     sf::Clock clock;
+    FixedTimestep timestep;
+    Kinematic previous = character;
     sf::Vector2f previousMousePos = sf::Vector2f(sf::Mouse::getPosition(window));
 
     while (window.isOpen()) {
@@ -95,37 +124,25 @@ int main() {
                 window.close();
         }
 
-        float deltaTime = clock.restart().asSeconds();
-        if (deltaTime == 0) continue; 
-
-        // Sample the current mouse position
-        sf::Vector2f currentMousePos = sf::Vector2f(sf::Mouse::getPosition(window));
-        // Calculating mouse velocity
-        sf::Vector2f mouseVelocity = (currentMousePos - previousMousePos) / deltaTime;
-        previousMousePos = currentMousePos;
-
-        // Creating a target kinematic based on mouse data.
-        Kinematic target;
-        target.position = currentMousePos;  
-        target.velocity = mouseVelocity;
-        target.orientation = 0.f;
-        target.rotation = 0.f;
-
-        // steering output from velocity matching
-        SteeringOutput steering = velocityMatching.getSteering(character, target, deltaTime);
-
-        // Updating the character's state
-        character.velocity += steering.linear * deltaTime;
-        character.position += character.velocity * deltaTime;
-
-        // Updating orientation 
-        if (std::abs(character.velocity.x) > 0.01f || std::abs(character.velocity.y) > 0.01f) {
-            character.orientation = std::atan2(character.velocity.y, character.velocity.x);
+        int steps = timestep.advance(clock.restart().asSeconds());
+        if (steps > 0) {
+            // Sample the current mouse position
+            sf::Vector2f currentMousePos = sf::Vector2f(sf::Mouse::getPosition(window));
+            // Calculating mouse velocity over the time being simulated
+            sf::Vector2f mouseVelocity = (currentMousePos - previousMousePos) / (steps * timestep.getStep());
+            previousMousePos = currentMousePos;
+
+            for (int i = 0; i < steps; i++) {
+                previous = character;
+                updateCharacter(character, mouseTarget(currentMousePos, mouseVelocity),
+                                velocityMatching, timestep.getStep());
+            }
         }
 
         // updating converting radians to degrees
-        boidSprite.setPosition(character.position);
-        boidSprite.setRotation(character.orientation * 180.f / 3.14159f);
+        Kinematic shown = interpolateKinematic(previous, character, timestep.getAlpha());
+        boidSprite.setPosition(shown.position);
+        boidSprite.setRotation(shown.orientation * 180.f / 3.14159f);
 
         window.clear(sf::Color::White);
         window.draw(boidSprite);
@@ -1,112 +1,79 @@
 #include <SFML/Graphics.hpp>
 #include "Steering.hpp"
+#include "DemoOptions.hpp"
+#include "TrailBuffer.hpp"
+#include "FixedTimestep.hpp"
+#include <cstdlib>
 #include <vector>
 #include <iostream>
 
 
 
-class Crumb : public sf::CircleShape {
-public:
-    Crumb(int id) : id(id) {
-        setRadius(5.f);
-        setFillColor(sf::Color(0, 69, 213, 248));
-        setPosition(-100, -100); // initially offscreen
-        setOrigin(5.f, 5.f);
-    }
-
-    void draw(sf::RenderWindow* window) {
-        window->draw(*this);
-    }
-
-    void drop(const sf::Vector2f& pos) {
-        setPosition(pos);
-    }
-
-private:
-    int id;
-};
-
-int main() {
-    sf::RenderWindow window(sf::VideoMode(640, 480), "Part 2");
-
-    sf::Texture boidTexture;
-    if (!boidTexture.loadFromFile("./src/boid-sm.png")) {
-        std::cerr << "Failed to load boid-sm.png" << std::endl;
-        return -1;
-    }
-
-    sf::Sprite boidSprite;
-    boidSprite.setTexture(boidTexture);
-    sf::FloatRect spriteBounds = boidSprite.getLocalBounds();
-    boidSprite.setOrigin(spriteBounds.width / 2.f, spriteBounds.height / 2.f);
-    boidSprite.setScale(4.0f, 4.0f);
-
-    Kinematic character;
-    character.position = sf::Vector2f(400.f, 300.f);
-    character.velocity = sf::Vector2f(0.f, 0.f);
-    character.orientation = 0.f;
-    character.rotation = 0.f;
-
-    // The target kinematic starts at the character's position.
-    Kinematic targetKinematic;
-    targetKinematic.position = character.position;
-    targetKinematic.velocity = sf::Vector2f(0.f, 0.f);
-    targetKinematic.orientation = character.orientation;
-    targetKinematic.rotation = 0.f;
-
-    // Arrive and Align behaviors.
-    ArriveBehavior arrive(
+// Arrive and Align behaviors.
+ArriveBehavior makeArrive() {
+    return ArriveBehavior(
         200.f,    // Maximum linear acceleration (pixels/second^2)
         300.f,    // Maximum speed (pixels/second)
         15.f,      // Target radius: if within 5 pixels, consider arrived (and no further acceleration)
         20.f,    // Slow radius: begin deceleration when within 200 pixels of the target
         0.2f      // Time to target: time over which to achieve the target speed (in seconds)
     );
+}
 
-    AlignBehavior align(
+AlignBehavior makeAlign() {
+    return AlignBehavior(
         200.f,          // Maximum angular acceleration (radians/second^2)
         PI / 4.0f,      // Maximum rotation speed (radians/second) - here 90° per second
         0.1f,         // Satisfaction radius: if within 0.05 radians, no further rotation is needed
         0.1f,          // Deceleration radius: begin decelerating rotation when within 0.5 radians
         0.1f           // Time to target: time over which to achieve the target rotation (in seconds)
     );
+}
 
-
-    sf::Clock clock;
-    // The target position is updated on mouse clicks.
-    sf::Vector2f targetPos = character.position;
-    // Freeze flag: if true, the boid remains stationary at the target.
-    bool frozen = false;
-    float finalOrientation = character.orientation;
-
- 
-
-    const int maxBreadcrumbs = 50;
-    std::vector<Crumb> breadcrumbs;
-    for (int i = 0; i < maxBreadcrumbs; i++) {
-        breadcrumbs.push_back(Crumb(i));
+// The character, the point it is heading for, and its freeze state.
+struct ArriveAgent {
+    Kinematic character;
+    Kinematic targetKinematic;
+    sf::Vector2f targetPos;     // updated on mouse clicks
+    bool frozen;                // once true, the boid remains at the target
+    float finalOrientation;
+
+    explicit ArriveAgent(sf::Vector2f start) {
+        character.position = start;
+        character.velocity = sf::Vector2f(0.f, 0.f);
+        character.orientation = 0.f;
+        character.rotation = 0.f;
+
+        // The target kinematic starts at the character's position.
+        targetKinematic.position = character.position;
+        targetKinematic.velocity = sf::Vector2f(0.f, 0.f);
+        targetKinematic.orientation = character.orientation;
+        targetKinematic.rotation = 0.f;
+        targetPos = character.position;
+        frozen = false;
+        finalOrientation = character.orientation;
     }
-    int crumbIndex = 0;
-    float dropTimer = 0.f;
-    const float dropInterval = 0.2f; // drop a crumb every 0.2 seconds
 
-   
+    // Unfreezes and heads for a new target.
+    void setTarget(sf::Vector2f position) {
+        targetPos = position;
+        frozen = false;
+    }
 
-    while (window.isOpen()) {
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed)
-                window.close();
-            // On left mouse click, update target position and unfreeze.
-            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
-                targetPos = sf::Vector2f(static_cast<float>(event.mouseButton.x),
-                                         static_cast<float>(event.mouseButton.y));
-                frozen = false;
-            }
+    void update(ArriveBehavior& arrive, AlignBehavior& align, float deltaTime) {
+        float distance = aim();
+        SteeringOutput arriveSteering = SteeringOutput{ sf::Vector2f(0.f, 0.f), 0.f };
+        SteeringOutput alignSteering = arriveSteering;
+        if (!frozen) {
+            // Getting steering outputs.
+            arriveSteering = arrive.getSteering(character, targetKinematic, deltaTime);
+            alignSteering = align.getSteering(character, targetKinematic, deltaTime);
         }
+        apply(arriveSteering, alignSteering, distance, deltaTime);
+    }
 
-        float deltaTime = clock.restart().asSeconds();
-
+    // Points targetKinematic at targetPos and returns the distance to it.
+    float aim() {
         targetKinematic.position = targetPos;
         sf::Vector2f toTarget = targetPos - character.position;
         float distance = vectorLength(toTarget);
@@ -114,12 +81,14 @@ int main() {
             targetKinematic.orientation = std::atan2(toTarget.y, toTarget.x);
         else
             targetKinematic.orientation = character.orientation;
+        return distance;
+    }
 
+    // The rest of a step, given the steering for the current aim(). The
+    // steering is ignored while frozen.
+    void apply(const SteeringOutput& arriveSteering, const SteeringOutput& alignSteering,
+               float distance, float deltaTime) {
         if (!frozen) {
-            // Getting steering outputs.
-            SteeringOutput arriveSteering = arrive.getSteering(character, targetKinematic, deltaTime);
-            SteeringOutput alignSteering = align.getSteering(character, targetKinematic, deltaTime);
-
             // Updating linear movement.
             character.velocity += arriveSteering.linear * deltaTime;
             character.position += character.velocity * deltaTime;
@@ -148,22 +117,122 @@ int main() {
             character.velocity = sf::Vector2f(0,0);
             character.rotation = 0.f;
         }
+    }
+};
 
-        // Update sprite position and rotation.
-        boidSprite.setPosition(character.position);
-        boidSprite.setRotation(character.orientation * 180.f / PI);
-
-        // Drop breadcrumbs
-        dropTimer += deltaTime;
-        if (dropTimer >= dropInterval) {
-            dropTimer = 0.f;
-            breadcrumbs[crumbIndex].drop(character.position);
-            crumbIndex = (crumbIndex + 1) % maxBreadcrumbs;
+// Steps the agents without a window or texture; see DemoOptions.hpp. Mouse
+// clicks are replaced by a new random target for every agent every
+// retargetInterval seconds. Steering runs as getSteeringBatch over the whole
+// crowd, e.g. --boids 50000.
+int runHeadless(const DemoOptions& options) {
+    const float retargetInterval = 2.f;
+    std::srand(options.seed);
+    const int numAgents = options.boidsOr(1);
+
+    ArriveBehavior arrive = makeArrive();
+    AlignBehavior align = makeAlign();
+    std::vector<ArriveAgent> agents(numAgents, ArriveAgent(sf::Vector2f(400.f, 300.f)));
+    std::vector<Kinematic> characters(numAgents), targets(numAgents);
+    std::vector<SteeringOutput> arriveSteering(numAgents), alignSteering(numAgents);
+    std::vector<float> distances(numAgents);
+
+    float retargetTimer = 0.f;
+    HeadlessTimer timer;
+    for (int frame = 0; frame < options.frames; frame++) {
+        retargetTimer -= options.dt;
+        if (retargetTimer <= 0.f) {
+            retargetTimer = retargetInterval;
+            for (auto& agent : agents)
+                agent.setTarget(sf::Vector2f(static_cast<float>(std::rand() % 640),
+                                             static_cast<float>(std::rand() % 480)));
+        }
+        // One batch per behavior for the whole crowd.
+        for (int i = 0; i < numAgents; i++) {
+            distances[i] = agents[i].aim();
+            characters[i] = agents[i].character;
+            targets[i] = agents[i].targetKinematic;
         }
+        arrive.getSteeringBatch(characters, targets, arriveSteering, options.dt);
+        align.getSteeringBatch(characters, targets, alignSteering, options.dt);
+        for (int i = 0; i < numAgents; i++)
+            agents[i].apply(arriveSteering[i], alignSteering[i], distances[i], options.dt);
+    }
+    double seconds = timer.seconds();
+
+    StateChecksum checksum;
+    for (const auto& agent : agents)
+        checksum.addKinematic(agent.character);
+    reportHeadless("Part 2", options, numAgents, seconds, checksum.value());
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    DemoOptions options = parseDemoOptions(argc, argv);
+    if (options.headless)
+        return runHeadless(options);
+
+    sf::RenderWindow window(sf::VideoMode(640, 480), "Part 2");
+
+    sf::Texture boidTexture;
+    if (!boidTexture.loadFromFile("./src/boid-sm.png")) {
+        std::cerr << "Failed to load boid-sm.png" << std::endl;
+        return -1;
+    }
+
+    sf::Sprite boidSprite;
+    boidSprite.setTexture(boidTexture);
+    sf::FloatRect spriteBounds = boidSprite.getLocalBounds();
+    boidSprite.setOrigin(spriteBounds.width / 2.f, spriteBounds.height / 2.f);
+    boidSprite.setScale(4.0f, 4.0f);
+
+    ArriveAgent agent(sf::Vector2f(400.f, 300.f));
+
+    ArriveBehavior arrive = makeArrive();
+    AlignBehavior align = makeAlign();
+
+
+    sf::Clock clock;
+    FixedTimestep timestep;
+    Kinematic previous = agent.character;
+
+    // 50 crumbs, one every 0.2 seconds.
+    TrailBuffer trails(1, 50, 0.2f);
+    TrailStyle trailStyle;
+    trailStyle.radius = 5.f;
+    trailStyle.color = sf::Color(0, 69, 213, 248);
+    trails.setStyle(trailStyle);
+
+   
+
+    while (window.isOpen()) {
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            if (event.type == sf::Event::Closed)
+                window.close();
+            // On left mouse click, update target position and unfreeze.
+            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+                agent.setTarget(sf::Vector2f(static_cast<float>(event.mouseButton.x),
+                                             static_cast<float>(event.mouseButton.y)));
+            }
+        }
+
+        int steps = timestep.advance(clock.restart().asSeconds());
+        for (int i = 0; i < steps; i++) {
+            previous = agent.character;
+            agent.update(arrive, align, timestep.getStep());
+
+            // Drop breadcrumbs
+            trails.advance(timestep.getStep());
+            trails.update(0, agent.character.position);
+        }
+
+        // Update sprite position and rotation.
+        Kinematic shown = interpolateKinematic(previous, agent.character, timestep.getAlpha());
+        boidSprite.setPosition(shown.position);
+        boidSprite.setRotation(shown.orientation * 180.f / PI);
 
         window.clear(sf::Color::White);
-        for (auto& crumb : breadcrumbs)
-            crumb.draw(&window);
+        trails.draw(window);
         window.draw(boidSprite);
         window.display();
     }
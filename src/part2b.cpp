@@ -1,107 +1,83 @@
 #include <SFML/Graphics.hpp>
 #include "Steering.hpp"
+#include "SteeringComposition.hpp"
+#include "DemoOptions.hpp"
+#include "TrailBuffer.hpp"
+#include "FixedTimestep.hpp"
+#include <cstdlib>
 #include <vector>
 #include <iostream>
 
 
 
-class Crumb : public sf::CircleShape {
-public:
-    Crumb(int id) : id(id) {
-        setRadius(5.f);
-        setFillColor(sf::Color(0, 0, 255, 255));
-        setPosition(-100, -100); // initially offscreen
-        setOrigin(5.f, 5.f);
-    }
-
-    void draw(sf::RenderWindow* window) {
-        window->draw(*this);
-    }
-
-    void drop(const sf::Vector2f& pos) {
-        setPosition(pos);
-    }
-
-private:
-    int id;
-};
-
-int main() {
-    sf::RenderWindow window(sf::VideoMode(640, 480), "Part 2");
-
-    sf::Texture boidTexture;
-    if (!boidTexture.loadFromFile("./src/boid-sm.png")) {
-        std::cerr << "Failed to load boid-sm.png" << std::endl;
-        return -1;
-    }
-
-    sf::Sprite boidSprite;
-    boidSprite.setTexture(boidTexture);
-    sf::FloatRect spriteBounds = boidSprite.getLocalBounds();
-    boidSprite.setOrigin(spriteBounds.width / 2.f, spriteBounds.height / 2.f);
-    boidSprite.setScale(4.0f, 4.0f);
-
-    Kinematic character;
-    character.position = sf::Vector2f(400.f, 300.f);
-    character.velocity = sf::Vector2f(0.f, 0.f);
-    character.orientation = 0.f;
-    character.rotation = 0.f;
-
-    // The target kinematic starts at the character's position.
-    Kinematic targetKinematic;
-    targetKinematic.position = character.position;
-    targetKinematic.velocity = sf::Vector2f(0.f, 0.f);
-    targetKinematic.orientation = character.orientation;
-    targetKinematic.rotation = 0.f;
-
-    // Arrive and Align behaviors.
-    ArriveBehavior arrive(
+// Arrive and Align behaviors.
+ArriveBehavior makeArrive() {
+    return ArriveBehavior(
         300.f,    // Max linear acceleration
         250.f,    // Max speed 
         5.f,      // if within this, consider arrived 
         200.f,    // begin deceleration when within 200 pixels of the target
         0.05f      // time to achieve the target speed
     );
+}
 
-    AlignBehavior align(
+AlignBehavior makeAlign() {
+    return AlignBehavior(
         18.f,          // Max angular acceleration
         PI / 1.f,      // Max rotation speed
         0.05f,         // if within this, no further rotation is needed
         0.5f,          // begin decelerating rotation when within this
         0.1f           // time to achieve the target rotation
     );
+}
 
+// Arrive moves the boid and Align turns it; one blend steers both.
+typedef Blend<ArriveBehavior, AlignBehavior> ArriveAndAlign;
 
-    sf::Clock clock;
-    sf::Vector2f targetPos = character.position;
-    // Freeze flag: once true, the boid remains at the target.
-    bool frozen = false;
-    float finalOrientation = character.orientation;
-
+ArriveAndAlign makeSteering() {
+    return ArriveAndAlign({ 1.f, 1.f }, makeArrive(), makeAlign());
+}
 
-    const int maxBreadcrumbs = 150;
-    std::vector<Crumb> breadcrumbs;
-    for (int i = 0; i < maxBreadcrumbs; i++) {
-        breadcrumbs.push_back(Crumb(i));
+// The character, the point it is heading for, and its freeze state.
+struct ArriveAgent {
+    Kinematic character;
+    Kinematic targetKinematic;
+    sf::Vector2f targetPos;     // updated on mouse clicks
+    bool frozen;                // once true, the boid remains at the target
+    float finalOrientation;
+
+    explicit ArriveAgent(sf::Vector2f start) {
+        character.position = start;
+        character.velocity = sf::Vector2f(0.f, 0.f);
+        character.orientation = 0.f;
+        character.rotation = 0.f;
+
+        // The target kinematic starts at the character's position.
+        targetKinematic.position = character.position;
+        targetKinematic.velocity = sf::Vector2f(0.f, 0.f);
+        targetKinematic.orientation = character.orientation;
+        targetKinematic.rotation = 0.f;
+        targetPos = character.position;
+        frozen = false;
+        finalOrientation = character.orientation;
     }
-    int crumbIndex = 0;
-    float dropTimer = 0.f;
-    const float dropInterval = 0.2f; // drop a crumb every 0.2 seconds
 
-    while (window.isOpen()) {
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed)
-                window.close();
-            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
-                targetPos = sf::Vector2f(static_cast<float>(event.mouseButton.x),
-                                         static_cast<float>(event.mouseButton.y));
-                frozen = false;
-            }
-        }
+    // Unfreezes and heads for a new target.
+    void setTarget(sf::Vector2f position) {
+        targetPos = position;
+        frozen = false;
+    }
 
-        float deltaTime = clock.restart().asSeconds();
+    void update(ArriveAndAlign& steering, float deltaTime) {
+        float distance = aim();
+        SteeringOutput output = SteeringOutput{ sf::Vector2f(0.f, 0.f), 0.f };
+        if (!frozen)
+            output = steering.steer(character, targetKinematic, deltaTime);
+        apply(output, distance, deltaTime);
+    }
 
+    // Points targetKinematic at targetPos and returns the distance to it.
+    float aim() {
         // Update the target kinematic.
         targetKinematic.position = targetPos;
         sf::Vector2f toTarget = targetPos - character.position;
@@ -110,14 +86,15 @@ int main() {
             targetKinematic.orientation = std::atan2(toTarget.y, toTarget.x);
         else
             targetKinematic.orientation = character.orientation;
+        return distance;
+    }
 
+    // The rest of a step, given the steering for the current aim(). The
+    // steering is ignored while frozen.
+    void apply(const SteeringOutput& steering, float distance, float deltaTime) {
         if (!frozen) {
-            // Get steering outputs.
-            SteeringOutput arriveSteering = arrive.getSteering(character, targetKinematic, deltaTime);
-            SteeringOutput alignSteering = align.getSteering(character, targetKinematic, deltaTime);
-
             // Update linear movement.
-            character.velocity += arriveSteering.linear * deltaTime;
+            character.velocity += steering.linear * deltaTime;
             character.position += character.velocity * deltaTime;
 
             bool arrived = (distance < 1.f) && (vectorLength(character.velocity) < 0.1f);
@@ -129,7 +106,7 @@ int main() {
                 frozen = true;
             } else {
                 // Update angular movement.
-                character.rotation += alignSteering.angular * deltaTime;
+                character.rotation += steering.angular * deltaTime;
                 character.orientation += character.rotation * deltaTime;
                 character.orientation = mapToRange(character.orientation);
             }
@@ -143,21 +120,113 @@ int main() {
             character.velocity = sf::Vector2f(0,0);
             character.rotation = 0.f;
         }
+    }
+};
+
+// Steps the agents without a window or texture; see DemoOptions.hpp. Mouse
+// clicks are replaced by a new random target for every agent every
+// retargetInterval seconds. Steering runs as one batch over the whole
+// crowd, e.g. --boids 50000.
+int runHeadless(const DemoOptions& options) {
+    const float retargetInterval = 2.f;
+    std::srand(options.seed);
+    const int numAgents = options.boidsOr(1);
+
+    ArriveAndAlign steering = makeSteering();
+    std::vector<ArriveAgent> agents(numAgents, ArriveAgent(sf::Vector2f(400.f, 300.f)));
+    std::vector<Kinematic> characters(numAgents), targets(numAgents);
+    std::vector<SteeringOutput> outputs(numAgents);
+    std::vector<float> distances(numAgents);
+
+    float retargetTimer = 0.f;
+    HeadlessTimer timer;
+    for (int frame = 0; frame < options.frames; frame++) {
+        retargetTimer -= options.dt;
+        if (retargetTimer <= 0.f) {
+            retargetTimer = retargetInterval;
+            for (auto& agent : agents)
+                agent.setTarget(sf::Vector2f(static_cast<float>(std::rand() % 640),
+                                             static_cast<float>(std::rand() % 480)));
+        }
+        // Every agent is aimed, then the whole crowd is steered at once.
+        for (int i = 0; i < numAgents; i++) {
+            distances[i] = agents[i].aim();
+            characters[i] = agents[i].character;
+            targets[i] = agents[i].targetKinematic;
+        }
+        steering.steerBatch(characters, targets, outputs, options.dt);
+        for (int i = 0; i < numAgents; i++)
+            agents[i].apply(outputs[i], distances[i], options.dt);
+    }
+    double seconds = timer.seconds();
+
+    StateChecksum checksum;
+    for (const auto& agent : agents)
+        checksum.addKinematic(agent.character);
+    reportHeadless("Part 2", options, numAgents, seconds, checksum.value());
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    DemoOptions options = parseDemoOptions(argc, argv);
+    if (options.headless)
+        return runHeadless(options);
+
+    sf::RenderWindow window(sf::VideoMode(640, 480), "Part 2");
+
+    sf::Texture boidTexture;
+    if (!boidTexture.loadFromFile("./src/boid-sm.png")) {
+        std::cerr << "Failed to load boid-sm.png" << std::endl;
+        return -1;
+    }
+
+    sf::Sprite boidSprite;
+    boidSprite.setTexture(boidTexture);
+    sf::FloatRect spriteBounds = boidSprite.getLocalBounds();
+    boidSprite.setOrigin(spriteBounds.width / 2.f, spriteBounds.height / 2.f);
+    boidSprite.setScale(4.0f, 4.0f);
+
+    ArriveAgent agent(sf::Vector2f(400.f, 300.f));
+
+    ArriveAndAlign steering = makeSteering();
+
+    sf::Clock clock;
+    FixedTimestep timestep;
+    Kinematic previous = agent.character;
+
+    // 150 crumbs, one every 0.2 seconds.
+    TrailBuffer trails(1, 150, 0.2f);
+    TrailStyle trailStyle;
+    trailStyle.radius = 5.f;
+    trails.setStyle(trailStyle);
+
+    while (window.isOpen()) {
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            if (event.type == sf::Event::Closed)
+                window.close();
+            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+                agent.setTarget(sf::Vector2f(static_cast<float>(event.mouseButton.x),
+                                             static_cast<float>(event.mouseButton.y)));
+            }
+        }
 
-        boidSprite.setPosition(character.position);
-        boidSprite.setRotation(character.orientation * 180.f / PI);
+        int steps = timestep.advance(clock.restart().asSeconds());
+        for (int i = 0; i < steps; i++) {
+            previous = agent.character;
+            agent.update(steering, timestep.getStep());
 
-        // Drop breadcrumbs.
-        dropTimer += deltaTime;
-        if (dropTimer >= dropInterval) {
-            dropTimer = 0.f;
-            breadcrumbs[crumbIndex].drop(character.position);
-            crumbIndex = (crumbIndex + 1) % maxBreadcrumbs;
+            // Drop breadcrumbs.
+            trails.advance(timestep.getStep());
+            trails.update(0, agent.character.position);
         }
 
+        Kinematic shown = interpolateKinematic(previous, agent.character, timestep.getAlpha());
+        boidSprite.setPosition(shown.position);
+        boidSprite.setRotation(shown.orientation * 180.f / PI);
+
         window.clear(sf::Color::White);
-        for (auto& crumb : breadcrumbs)
-            crumb.draw(&window);
+        trails.draw(window);
         window.draw(boidSprite);
         window.display();
     }
@@ -2,40 +2,27 @@
 #include <vector>
 #include <cstdlib>
 #include <ctime>
+#include <memory>
 #include "Steering.hpp"
+#include "DemoOptions.hpp"
+#include "TrailBuffer.hpp"
+#include "FixedTimestep.hpp"
+#include "KinematicRecording.hpp"
+#include "ReplayDemo.hpp"
 
 const sf::Vector2f TOP_RIGHT(550, 0);
 const sf::Vector2f BOT_RIGHT(550, 550);
 const sf::Vector2f BOT_LEFT(0, 550);
 const sf::Vector2f TOP_LEFT(0, 0);
-
-class crumb : public sf::CircleShape {
-public:
-    crumb(int id) : id(id) {
-        this->setRadius(5.f);
-        this->setFillColor(sf::Color(0, 0, 255, 255));
-        this->setPosition(-100.f, -100.f);
-    }
-
-    void draw(sf::RenderWindow* window) {
-        window->draw(*this);
-    }
-
-    void drop(float x, float y) {
-        this->setPosition(x, y);
-    }
-    void drop(const sf::Vector2f& position) {
-        this->setPosition(position);
-    }
-
-private:
-    int id;
-};
+const sf::Vector2u WINDOW_SIZE(640, 480);
+// The Boid settings below, for --record headers.
+const char* const BOID_PARAMS = "maxSpeed=100\nmaxAccel=50\nwanderOffset=20\nwanderRadius=100\nwanderRate=2\nwanderTimeToTarget=0.1\n";
 
 class Boid {
 public:
-    Boid(sf::RenderWindow* win, std::vector<crumb>* crumbs, const sf::Texture& texture)
-        : window(win), breadcrumbs(crumbs)
+    // texture may be null when running headless.
+    Boid(sf::Vector2u worldSize, TrailBuffer* trails, std::size_t trail, const sf::Texture* texture)
+        : worldSize(worldSize), trails(trails), trail(trail)
     {
         kinematic.position = sf::Vector2f(300.f, 300.f);
         kinematic.velocity = sf::Vector2f(50.f, 0.f);
@@ -48,14 +35,14 @@ public:
                                             100.f,
                                             2.0f,
                                             0.1f);
-        boidSprite.setTexture(texture);
-        sf::FloatRect bounds = boidSprite.getLocalBounds();
-        boidSprite.setOrigin(bounds.width / 2.f, bounds.height / 2.f);
-        boidSprite.setScale(4.f, 4.f);
+        if (texture) {
+            boidSprite.setTexture(*texture);
+            sf::FloatRect bounds = boidSprite.getLocalBounds();
+            boidSprite.setOrigin(bounds.width / 2.f, bounds.height / 2.f);
+            boidSprite.setScale(4.f, 4.f);
+        }
         boidSprite.setPosition(kinematic.position);
-
-        dropTimer = 0.f;
-        dropInterval = 0.2f;
+        previous = kinematic;
     }
 
     ~Boid() {
@@ -63,6 +50,7 @@ public:
     }
 
     void update(float deltaTime) {
+        previous = kinematic;
         SteeringOutput steering = wanderBehavior->getSteering(kinematic, kinematic, deltaTime);
         kinematic.velocity += steering.linear * deltaTime;
         if (vectorLength(kinematic.velocity) > maxSpeed)
@@ -70,10 +58,8 @@ public:
         kinematic.position += kinematic.velocity * deltaTime;
         if (vectorLength(kinematic.velocity) > 0.001f)
             kinematic.orientation = std::atan2(kinematic.velocity.y, kinematic.velocity.x);
-        boidSprite.setPosition(kinematic.position);
-        boidSprite.setRotation(kinematic.orientation * 180 / PI);
 
-        sf::Vector2u winSize = window->getSize();
+        sf::Vector2u winSize = worldSize;
         if (kinematic.position.x < 0.f)
             kinematic.position.x = static_cast<float>(winSize.x);
         else if (kinematic.position.x > winSize.x)
@@ -83,46 +69,92 @@ public:
         else if (kinematic.position.y > winSize.y)
             kinematic.position.y = 0.f;
 
-        dropTimer += deltaTime;
-        if (dropTimer >= dropInterval) {
-            dropTimer = 0.f;
-            breadcrumbs->at(crumbIndex).drop(kinematic.position);
-            crumbIndex = (crumbIndex + 1) % breadcrumbs->size();
-        }
+        trails->update(trail, kinematic.position);
     }
 
-    void draw() {
+    // Draws the boid alpha of the way from its previous step to its current one.
+    void draw(sf::RenderWindow* window, float alpha) {
+        Kinematic shown = interpolateKinematic(previous, kinematic, alpha, worldSize.y / 2.f);
+        boidSprite.setPosition(shown.position);
+        boidSprite.setRotation(shown.orientation * 180 / PI);
         window->draw(boidSprite);
     }
 
+    const Kinematic& getKinematic() const {
+        return kinematic;
+    }
+
 private:
-    sf::RenderWindow* window;
+    sf::Vector2u worldSize;
     Kinematic kinematic;
+    Kinematic previous;   // state before the last update, for interpolation
     float maxSpeed;
     float maxAcceleration;
     WanderBehavior* wanderBehavior;
     sf::Sprite boidSprite;
-    std::vector<crumb>* breadcrumbs;
-    float dropTimer;
-    float dropInterval;
-    size_t crumbIndex = 0;
+    TrailBuffer* trails;
+    std::size_t trail;
 };
 
-int main()
+// Steps the boids without a window or texture; see DemoOptions.hpp.
+int runHeadless(const DemoOptions& options)
+{
+    std::srand(options.seed);
+    const int numBoids = options.boidsOr(1);
+
+    TrailBuffer trails(numBoids, 20, 0.2f);
+    std::vector<std::unique_ptr<Boid>> boids;
+    for (int i = 0; i < numBoids; i++)
+        boids.emplace_back(new Boid(WINDOW_SIZE, &trails, i, nullptr));
+    KinematicRecording recording(options, numBoids, options.dt, options.seed, BOID_PARAMS, WINDOW_SIZE);
+    auto current = [&boids](std::size_t i) { return boids[i]->getKinematic(); };
+    recording.record(current);
+
+    HeadlessTimer timer;
+    for (int frame = 0; frame < options.frames; frame++) {
+        trails.advance(options.dt);
+        for (auto& boid : boids)
+            boid->update(options.dt);
+        recording.record(current);
+    }
+    double seconds = timer.seconds();
+
+    StateChecksum checksum;
+    for (const auto& boid : boids)
+        checksum.addKinematic(boid->getKinematic());
+    reportHeadless("Part 3", options, numBoids, seconds, checksum.value());
+    reportTrails(trails);
+    recording.report(seconds);
+    return 0;
+}
+
+
+int main(int argc, char** argv)
 {
-    std::srand(static_cast<unsigned>(std::time(nullptr)));
-    sf::RenderWindow window(sf::VideoMode(640, 480), "Part 3");
+    DemoOptions options = parseDemoOptions(argc, argv);
+    if (options.replay)
+        return runReplay(options);
+    if (options.headless)
+        return runHeadless(options);
+
+    const unsigned seed = static_cast<unsigned>(std::time(nullptr));
+    std::srand(seed);
+    sf::RenderWindow window(sf::VideoMode(WINDOW_SIZE.x, WINDOW_SIZE.y), "Part 3");
     window.setFramerateLimit(60);
     sf::Texture boidTexture;
     if (!boidTexture.loadFromFile("./src/boid-sm.png")) {
         return -1;
     }
-    std::vector<crumb> breadcrumbs;
-    for (int i = 0; i < 20; i++) {
-        breadcrumbs.push_back(crumb(i));
-    }
-    Boid boid(&window, &breadcrumbs, boidTexture);
+    TrailBuffer trails(1, 20, 0.2f);
+    TrailStyle trailStyle;
+    trailStyle.radius = 5.f;
+    trails.setStyle(trailStyle);
+    Boid boid(WINDOW_SIZE, &trails, 0, &boidTexture);
     sf::Clock clock;
+    FixedTimestep timestep;
+    KinematicRecording recording(options, 1, timestep.getStep(), seed, BOID_PARAMS, WINDOW_SIZE);
+    auto current = [&boid](std::size_t) { return boid.getKinematic(); };
+    recording.record(current);
     while (window.isOpen())
     {
         sf::Event event;
@@ -132,12 +164,15 @@ int main()
                 window.close();
         }
         
-        float deltaTime = clock.restart().asSeconds();
-        boid.update(deltaTime);
+        int steps = timestep.advance(clock.restart().asSeconds());
+        for (int i = 0; i < steps; i++) {
+            trails.advance(timestep.getStep());
+            boid.update(timestep.getStep());
+            recording.record(current);
+        }
         window.clear(sf::Color::White);
-        for (auto& c : breadcrumbs)
-            c.draw(&window);
-        boid.draw();
+        trails.draw(window);
+        boid.draw(&window, timestep.getAlpha());
         window.display();
     }
     return 0;
@@ -1,44 +1,4 @@
-#include <SFML/Graphics.hpp>
-#include <cstdlib>
-#include <ctime>
-#include <vector>
-#include "flocking-wander.hpp"
-
-class crumb : public sf::CircleShape {
-public:
-    crumb(int id) {
-        this->id = id;
-        this->setRadius(1.5f);
-        this->setFillColor(sf::Color(0, 0, 255, 255));
-        this->setPosition(-100.f, -100.f);
-    }
-
-    void draw(sf::RenderWindow* window) {
-        window->draw(*this);
-    }
-
-    void drop(float x, float y) {
-        this->setPosition(x, y);
-    }
-    void drop(sf::Vector2f position) {
-        this->setPosition(position);
-    }
-
-private:
-    int id;
-};
-
-struct BoidBreadcrumbs {
-    std::vector<crumb> crumbs;
-    float drop_timer;
-    int crumb_idx;
-
-    BoidBreadcrumbs() : drop_timer(0.1f), crumb_idx(0) {
-        for (int i = 0; i < 10; ++i) {
-            crumbs.push_back(crumb(i));
-        }
-    }
-};
+#include "FlockDemo.hpp"
 
 const int windowWidth = 800;
 const int windowHeight = 600;
@@ -61,112 +21,45 @@ const float wanderTimeToTarget= 0.1f;
 const float initialSpeed      = 13.f;
 const float maxSpeed          = 13.f;
 
-int main()
-{
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
-
-    sf::Texture boidTexture;
-    if (!boidTexture.loadFromFile("src/boid-sm.png"))
-    {
-        return -1;
-    }
-    sf::Vector2u texSize = boidTexture.getSize();
-    sf::Vector2f textureOrigin(texSize.x / 2.f, texSize.y / 2.f);
-
-    std::vector<Kinematic> flock;
-    std::vector<FlockingBehavior> behaviors;
-    std::vector<sf::Sprite> sprites;
-    std::vector<BoidBreadcrumbs> boidBreadcrumbs;
-
-    for (int i = 0; i < numBoids; ++i)
-    {
-        Kinematic k;
-        k.position = sf::Vector2f(static_cast<float>(std::rand() % windowWidth),
-                                  static_cast<float>(std::rand() % windowHeight));
-        float angle = (std::rand() % 360) * (PI / 180.f);
-        k.velocity = sf::Vector2f(std::cos(angle), std::sin(angle)) * initialSpeed;
-        k.orientation = angle;
-        k.rotation = 0.f;
-        flock.push_back(k);
-
-        behaviors.push_back(FlockingBehavior(&flock,
-                                               neighborRadius, separationRadius,
-                                               separationWeight, alignmentWeight, cohesionWeight,
-                                               maxAccel,
-                                               wanderMaxAccel, wanderMaxSpeed, wanderOffset,
-                                               wanderRadius, wanderRate, wanderTimeToTarget));
-
-        sf::Sprite sprite;
-        sprite.setTexture(boidTexture);
-        sprite.setOrigin(textureOrigin);
-        sprite.setScale(1.f, 1.f);
-        sprites.push_back(sprite);
-
-        boidBreadcrumbs.push_back(BoidBreadcrumbs());
-    }
+// Neighbor lookups through a uniform grid instead of scanning the whole flock.
+const bool useSpatialGrid     = true;
+// Cached per-boid neighbor lists, reused until a boid moves more than skin/2.
+const bool useNeighborList    = true;
+const float neighborSkin      = 10.f;
+// SSE2/AVX2 neighbor kernel picked for this CPU at startup.
+const bool useSimdKernel      = true;
 
-    sf::RenderWindow window(sf::VideoMode(windowWidth, windowHeight), "Part 4");
-    window.setFramerateLimit(60);
-    sf::Clock clock;
-
-    while (window.isOpen())
-    {
-        sf::Event event;
-        while (window.pollEvent(event))
-        {
-            if (event.type == sf::Event::Closed)
-                window.close();
-        }
-
-        sf::Time dt = clock.restart();
-        float deltaTime = dt.asSeconds();
-
-        for (int i = 0; i < numBoids; ++i)
-        {
-            SteeringOutput steering = behaviors[i].getSteering(flock[i], flock[i], deltaTime);
-            flock[i].velocity += steering.linear * deltaTime;
-            flock[i].velocity = clamp(flock[i].velocity, maxSpeed);
-            flock[i].position += flock[i].velocity * deltaTime;
-
-            if (flock[i].position.x < 0) flock[i].position.x += windowWidth;
-            if (flock[i].position.y < 0) flock[i].position.y += windowHeight;
-            if (flock[i].position.x > windowWidth) flock[i].position.x -= windowWidth;
-            if (flock[i].position.y > windowHeight) flock[i].position.y -= windowHeight;
-
-            if (vectorLength(flock[i].velocity) > 0)
-                flock[i].orientation = std::atan2(flock[i].velocity.y, flock[i].velocity.x);
-        }
-
-        for (int i = 0; i < numBoids; ++i)
-        {
-            boidBreadcrumbs[i].drop_timer -= deltaTime;
-            if (boidBreadcrumbs[i].drop_timer <= 0.f)
-            {
-                boidBreadcrumbs[i].drop_timer = 0.3f;
-                boidBreadcrumbs[i].crumbs[boidBreadcrumbs[i].crumb_idx].drop(flock[i].position);
-                boidBreadcrumbs[i].crumb_idx = (boidBreadcrumbs[i].crumb_idx + 1) % 10;
-            }
-        }
-
-        window.clear(sf::Color::White);
-
-        for (int i = 0; i < numBoids; ++i)
-        {
-            for (auto& c : boidBreadcrumbs[i].crumbs)
-            {
-                c.draw(&window);
-            }
-        }
-
-        for (int i = 0; i < numBoids; ++i)
-        {
-            sprites[i].setPosition(flock[i].position);
-            sprites[i].setRotation(flock[i].orientation * 180.f / PI);
-            window.draw(sprites[i]);
-        }
-
-        window.display();
-    }
+FlockParams makeFlockParams()
+{
+    FlockParams params;
+    params.neighborRadius     = neighborRadius;
+    params.separationRadius   = separationRadius;
+    params.separationWeight   = separationWeight;
+    params.alignmentWeight    = alignmentWeight;
+    params.cohesionWeight     = cohesionWeight;
+    params.maxAccel           = maxAccel;
+    params.wanderMaxAccel     = wanderMaxAccel;
+    params.wanderMaxSpeed     = wanderMaxSpeed;
+    params.wanderOffset       = wanderOffset;
+    params.wanderRadius       = wanderRadius;
+    params.wanderRate         = wanderRate;
+    params.wanderTimeToTarget = wanderTimeToTarget;
+    params.maxSpeed           = maxSpeed;
+    params.worldWidth         = windowWidth;
+    params.worldHeight        = windowHeight;
+    params.useSpatialGrid     = useSpatialGrid;
+    params.useNeighborList    = useNeighborList;
+    params.neighborSkin       = neighborSkin;
+    params.useSimdKernel      = useSimdKernel;
+    return params;
+}
 
-    return 0;
+int main(int argc, char** argv)
+{
+    FlockDemoConfig config;
+    config.params = makeFlockParams();
+    config.numBoids = numBoids;
+    config.initialSpeed = initialSpeed;
+    config.title = "Part 4";
+    return runFlockDemo(config, argc, argv);
 }
@@ -0,0 +1,334 @@
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "FlockSimulation.hpp"
+#include "ParameterSweep.hpp"
+#include "Steering.hpp"
+
+// Parameter sweeps: many short headless runs over a grid or a random sample
+// of parameters, spread over every core, with one row of quality metrics
+// and the run's cost per parameter set (CSV).
+//
+//   ./sweep flock  name=values... [--random N] [--boids N] [--frames N]
+//                  [--collision R] [--dt S] [--seed N] [--threads N] [--out FILE]
+//   ./sweep arrive name=values... [--random N] [--seconds S] [--dt S]
+//                  [--seed N] [--threads N] [--out FILE]
+//
+// values is a,b,c or low:high[:count]. Without --random every combination is
+// run; with --random N, N sets are drawn (ranges uniformly, lists by
+// picking a value). Every run of a sweep starts from the same spawns, so
+// rows differ only by their parameters.
+//
+// e.g. ./sweep flock neighborRadius=40:80:5 separationWeight=50,150,300
+//      ./sweep arrive slowRadius=50:300:6 timeToTarget=0.05,0.1,0.2
+
+
+// Swept parameters of each scenario, by name.
+template <typename Params>
+struct SweepField {
+    const char* name;
+    float Params::*field;
+};
+
+static const SweepField<FlockParams> flockFields[] = {
+    { "neighborRadius", &FlockParams::neighborRadius },
+    { "separationRadius", &FlockParams::separationRadius },
+    { "separationWeight", &FlockParams::separationWeight },
+    { "alignmentWeight", &FlockParams::alignmentWeight },
+    { "cohesionWeight", &FlockParams::cohesionWeight },
+    { "maxAccel", &FlockParams::maxAccel },
+    { "wanderMaxAccel", &FlockParams::wanderMaxAccel },
+    { "wanderMaxSpeed", &FlockParams::wanderMaxSpeed },
+    { "wanderOffset", &FlockParams::wanderOffset },
+    { "wanderRadius", &FlockParams::wanderRadius },
+    { "wanderRate", &FlockParams::wanderRate },
+    { "wanderTimeToTarget", &FlockParams::wanderTimeToTarget },
+    { "maxSpeed", &FlockParams::maxSpeed },
+    { "worldWidth", &FlockParams::worldWidth },
+    { "worldHeight", &FlockParams::worldHeight },
+};
+
+// part2b's Arrive.
+struct ArriveParams {
+    float maxAccel = 300.f;
+    float maxSpeed = 250.f;
+    float targetRadius = 5.f;
+    float slowRadius = 200.f;
+    float timeToTarget = 0.05f;
+};
+
+static const SweepField<ArriveParams> arriveFields[] = {
+    { "maxAccel", &ArriveParams::maxAccel },
+    { "maxSpeed", &ArriveParams::maxSpeed },
+    { "targetRadius", &ArriveParams::targetRadius },
+    { "slowRadius", &ArriveParams::slowRadius },
+    { "timeToTarget", &ArriveParams::timeToTarget },
+};
+
+template <typename Params, std::size_t N>
+static bool applyPoint(const SweepField<Params> (&fields)[N], const std::vector<SweepAxis>& axes,
+                       const SweepPoint& point, Params& params) {
+    for (std::size_t a = 0; a < axes.size(); ++a) {
+        bool found = false;
+        for (const SweepField<Params>& f : fields)
+            if (axes[a].name == f.name) {
+                params.*f.field = point[a];
+                found = true;
+            }
+        if (!found)
+            return false;
+    }
+    return true;
+}
+
+template <typename Params, std::size_t N>
+static void printFieldNames(const SweepField<Params> (&fields)[N]) {
+    for (const SweepField<Params>& f : fields)
+        std::fprintf(stderr, " %s", f.name);
+    std::fprintf(stderr, "\n");
+}
+
+
+struct SweepOptions {
+    std::vector<SweepAxis> axes;
+    std::size_t random = 0;
+    int boids = 100;
+    int frames = 600;
+    float seconds = 6.f;
+    float collision = 5.f;
+    float dt = 1.f / 60.f;
+    unsigned seed = 1;
+    int threads = 0;
+    const char* out = nullptr;
+};
+
+// One row of results; scenarios leave the others' columns unused.
+struct SweepResult {
+    double milliseconds = 0.0;
+    // flock, averaged over frames sampled in the second half of the run
+    double alignment = 0.0;   // |mean heading|: 1 when every boid flies the same way
+    double cohesion = 0.0;    // mean distance to the center of a boid's neighbors
+    double neighbors = 0.0;   // mean neighbors within neighborRadius
+    double collisions = 0.0;  // pairs closer than --collision, per boid
+    // arrive, over the trials
+    double arrivalTime = 0.0; // mean seconds to reach targetRadius; --seconds if never
+    double overshoot = 0.0;   // largest distance past the target along the approach
+    double arrived = 0.0;     // fraction of trials that reached the target
+};
+
+
+// Flock quality from one frame; neighbor distances ignore the wrap-around.
+static void sampleFlock(const FlockState& flock, const FlockParams& params, float collision,
+                        SweepResult& sum, std::vector<int>& candidates) {
+    SpatialGrid grid(params.neighborRadius);
+    grid.rebuild(flock.size(), flock.positions());
+    sf::Vector2f heading(0.f, 0.f);
+    double cohesion = 0.0, neighbors = 0.0, collisions = 0.0;
+    int grouped = 0;
+    for (std::size_t i = 0; i < flock.size(); ++i) {
+        sf::Vector2f velocity = flock.velocity(i);
+        if (vectorLength(velocity) > 0.f)
+            heading += normalize(velocity);
+        grid.query(flock.position(i), params.neighborRadius, candidates);
+        sf::Vector2f center(0.f, 0.f);
+        int count = 0;
+        for (int j : candidates) {
+            float d = vectorLength(flock.position(j) - flock.position(i));
+            if (d < params.neighborRadius && static_cast<std::size_t>(j) != i) {
+                center += flock.position(j);
+                count++;
+                if (d < collision && static_cast<std::size_t>(j) > i)
+                    collisions += 1.0;
+            }
+        }
+        neighbors += count;
+        if (count > 0) {
+            cohesion += vectorLength(center / static_cast<float>(count) - flock.position(i));
+            grouped++;
+        }
+    }
+    double n = static_cast<double>(flock.size());
+    sum.alignment += vectorLength(heading) / n;
+    sum.cohesion += grouped > 0 ? cohesion / grouped : 0.0;
+    sum.neighbors += neighbors / n;
+    sum.collisions += collisions / n;
+}
+
+static SweepResult runFlock(const FlockParams& params, const SweepOptions& options) {
+    FlockSimulation simulation(params, 1);
+    std::mt19937 rng(options.seed);
+    std::uniform_real_distribution<float> x(0.f, params.worldWidth), y(0.f, params.worldHeight);
+    std::uniform_real_distribution<float> angle(0.f, 2.f * PI);
+    for (int i = 0; i < options.boids; ++i) {
+        Kinematic k;
+        k.position = sf::Vector2f(x(rng), y(rng));
+        k.orientation = angle(rng);
+        k.velocity = sf::Vector2f(std::cos(k.orientation), std::sin(k.orientation)) * params.maxSpeed;
+        k.rotation = 0.f;
+        simulation.addBoid(k, options.seed);
+    }
+
+    SweepResult result;
+    std::vector<int> candidates;
+    int samples = 0;
+    for (int frame = 1; frame <= options.frames; ++frame) {
+        simulation.step(options.dt);
+        if (frame * 2 >= options.frames && frame % 10 == 0) {
+            sampleFlock(simulation.state(), params, options.collision, result, candidates);
+            samples++;
+        }
+    }
+    if (samples > 0) {
+        result.alignment /= samples;
+        result.cohesion /= samples;
+        result.neighbors /= samples;
+        result.collisions /= samples;
+    }
+    return result;
+}
+
+// Eight trials from rest at the origin to targets 100 to 450 px away in
+// different directions, integrated as in part2b.
+static SweepResult runArrive(const ArriveParams& params, const SweepOptions& options) {
+    ArriveBehavior arrive(params.maxAccel, params.maxSpeed, params.targetRadius,
+                          params.slowRadius, params.timeToTarget);
+    std::mt19937 rng(options.seed);
+    std::uniform_real_distribution<float> angle(0.f, 2.f * PI);
+    const int trials = 8;
+    const int steps = static_cast<int>(options.seconds / options.dt);
+
+    SweepResult result;
+    for (int t = 0; t < trials; ++t) {
+        float heading = angle(rng);
+        sf::Vector2f axis(std::cos(heading), std::sin(heading));
+        Kinematic target{ axis * (100.f + 50.f * t), sf::Vector2f(0.f, 0.f), 0.f, 0.f };
+        Kinematic character{ sf::Vector2f(0.f, 0.f), sf::Vector2f(0.f, 0.f), 0.f, 0.f };
+        float arrivedAt = options.seconds;
+        float overshoot = 0.f;
+        for (int s = 1; s <= steps; ++s) {
+            SteeringOutput steering = arrive.steer(character, target, options.dt);
+            character.velocity += steering.linear * options.dt;
+            character.position += character.velocity * options.dt;
+            sf::Vector2f offset = character.position - target.position;
+            overshoot = std::max(overshoot, offset.x * axis.x + offset.y * axis.y);
+            if (arrivedAt == options.seconds && vectorLength(offset) <= params.targetRadius)
+                arrivedAt = s * options.dt;
+        }
+        result.arrivalTime += arrivedAt / trials;
+        result.overshoot = std::max(result.overshoot, static_cast<double>(overshoot));
+        result.arrived += (arrivedAt < options.seconds ? 1.0 : 0.0) / trials;
+    }
+    return result;
+}
+
+
+static bool parseSweepOptions(int argc, char** argv, SweepOptions& options) {
+    for (int i = 2; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (arg[0] != '-') {
+            SweepAxis axis;
+            if (!parseSweepAxis(arg, axis)) {
+                std::fprintf(stderr, "bad parameter '%s'; use name=a,b,c or name=low:high:count\n", arg);
+                return false;
+            }
+            options.axes.push_back(axis);
+        } else if (!value) {
+            std::fprintf(stderr, "missing value for '%s'\n", arg);
+            return false;
+        } else {
+            if (std::strcmp(arg, "--random") == 0) options.random = static_cast<std::size_t>(std::atol(value));
+            else if (std::strcmp(arg, "--boids") == 0) options.boids = std::atoi(value);
+            else if (std::strcmp(arg, "--frames") == 0) options.frames = std::atoi(value);
+            else if (std::strcmp(arg, "--seconds") == 0) options.seconds = static_cast<float>(std::atof(value));
+            else if (std::strcmp(arg, "--collision") == 0) options.collision = static_cast<float>(std::atof(value));
+            else if (std::strcmp(arg, "--dt") == 0) options.dt = static_cast<float>(std::atof(value));
+            else if (std::strcmp(arg, "--seed") == 0) options.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+            else if (std::strcmp(arg, "--threads") == 0) options.threads = std::atoi(value);
+            else if (std::strcmp(arg, "--out") == 0) options.out = value;
+            else std::fprintf(stderr, "ignoring unknown option '%s'\n", arg);
+            ++i;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    const bool flock = argc > 1 && std::strcmp(argv[1], "flock") == 0;
+    const bool arrive = argc > 1 && std::strcmp(argv[1], "arrive") == 0;
+    SweepOptions options;
+    if ((!flock && !arrive) || !parseSweepOptions(argc, argv, options)) {
+        std::fprintf(stderr, "usage: sweep flock|arrive name=values... [options]; see src/sweep.cpp\n");
+        return 1;
+    }
+
+    std::vector<SweepPoint> points = options.random > 0
+        ? sweepRandom(options.axes, options.random, options.seed)
+        : sweepGrid(options.axes);
+    // Check every name once up front rather than in each run.
+    FlockParams flockCheck;
+    ArriveParams arriveCheck;
+    if (flock ? !applyPoint(flockFields, options.axes, points[0], flockCheck)
+              : !applyPoint(arriveFields, options.axes, points[0], arriveCheck)) {
+        std::fprintf(stderr, "unknown parameter; %s takes:", argv[1]);
+        if (flock)
+            printFieldNames(flockFields);
+        else
+            printFieldNames(arriveFields);
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SweepResult> results = runSweep<SweepResult>(points, options.threads,
+        [&](std::size_t, const SweepPoint& point) {
+            auto begin = std::chrono::steady_clock::now();
+            SweepResult result;
+            if (flock) {
+                FlockParams params;
+                applyPoint(flockFields, options.axes, point, params);
+                result = runFlock(params, options);
+            } else {
+                ArriveParams params;
+                applyPoint(arriveFields, options.axes, point, params);
+                result = runArrive(params, options);
+            }
+            result.milliseconds = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - begin).count();
+            return result;
+        });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::FILE* out = options.out ? std::fopen(options.out, "w") : stdout;
+    if (!out) {
+        std::fprintf(stderr, "cannot write '%s'\n", options.out);
+        return 1;
+    }
+    std::fprintf(out, "run");
+    for (const SweepAxis& axis : options.axes)
+        std::fprintf(out, ",%s", axis.name.c_str());
+    std::fprintf(out, flock ? ",alignment,cohesion,neighbors,collisions,ms\n"
+                            : ",arrival_time,overshoot,arrived,ms\n");
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        const SweepResult& r = results[i];
+        std::fprintf(out, "%zu", i);
+        for (float value : points[i])
+            std::fprintf(out, ",%g", value);
+        if (flock)
+            std::fprintf(out, ",%.4f,%.3f,%.3f,%.4f,%.2f\n",
+                         r.alignment, r.cohesion, r.neighbors, r.collisions, r.milliseconds);
+        else
+            std::fprintf(out, ",%.4f,%.3f,%.3f,%.3f\n",
+                         r.arrivalTime, r.overshoot, r.arrived, r.milliseconds);
+    }
+    if (out != stdout)
+        std::fclose(out);
+    std::fprintf(stderr, "%zu runs in %.2f s\n", points.size(), seconds);
+    return 0;
+}
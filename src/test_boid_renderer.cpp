@@ -0,0 +1,118 @@
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "BoidRenderer.hpp"
+
+// Self-check for BoidRenderer: renders flocks into an sf::RenderTexture and
+// checks that every frame is one draw call whatever N is, that a boid's two
+// triangles have the corners and texture coordinates of a sprite centered
+// on it, and that the boid actually lands in the picture. Prints each
+// failure and exits non-zero if there was one.
+//
+//   ./test_boid_renderer
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        std::printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static bool near(const sf::Vector2f& a, const sf::Vector2f& b) {
+    return std::fabs(a.x - b.x) < 1e-3f && std::fabs(a.y - b.y) < 1e-3f;
+}
+
+static FlockState oneBoid(float x, float y, float orientation) {
+    FlockState flock;
+    Kinematic k;
+    k.position = sf::Vector2f(x, y);
+    k.velocity = sf::Vector2f(0.f, 0.f);
+    k.orientation = orientation;
+    k.rotation = 0.f;
+    flock.push_back(k);
+    return flock;
+}
+
+// corners: top-left, top-right, bottom-right, bottom-left of the sprite.
+static void checkQuad(const sf::VertexArray& vertices, const sf::Vector2f (&corners)[4],
+                      float texWidth, float texHeight, const char* label) {
+    const int corner[6] = { 0, 1, 2, 0, 2, 3 };
+    const sf::Vector2f tex[4] = { sf::Vector2f(0.f, 0.f), sf::Vector2f(texWidth, 0.f),
+                                  sf::Vector2f(texWidth, texHeight), sf::Vector2f(0.f, texHeight) };
+    check(vertices.getVertexCount() == BoidRenderer::verticesPerBoid, label);
+    for (int v = 0; v < 6 && v < static_cast<int>(vertices.getVertexCount()); ++v) {
+        char what[96];
+        std::snprintf(what, sizeof(what), "%s: vertex %d position", label, v);
+        check(near(vertices[v].position, corners[corner[v]]), what);
+        std::snprintf(what, sizeof(what), "%s: vertex %d texCoords", label, v);
+        check(near(vertices[v].texCoords, tex[corner[v]]), what);
+    }
+}
+
+int main()
+{
+    const unsigned width = 640, height = 480;
+    // 16 x 8 so a swapped width and height shows; black on a white target.
+    sf::Image image;
+    image.create(16, 8, sf::Color::Black);
+    sf::Texture texture;
+    sf::RenderTexture target;
+    if (!texture.loadFromImage(image) || !target.create(width, height)) {
+        std::printf("FAIL: cannot create the texture or render texture\n");
+        return 1;
+    }
+
+    // One draw call per frame at every N.
+    for (int n : { 1, 100, 10000 }) {
+        BoidRenderer boids(texture);
+        std::srand(1);
+        FlockState flock;
+        for (int i = 0; i < n; ++i) {
+            Kinematic k;
+            k.position = sf::Vector2f(static_cast<float>(std::rand() % width),
+                                      static_cast<float>(std::rand() % height));
+            k.velocity = sf::Vector2f(0.f, 0.f);
+            k.orientation = (std::rand() % 360) * (PI / 180.f);
+            k.rotation = 0.f;
+            flock.push_back(k);
+        }
+        for (int frame = 1; frame <= 3; ++frame) {
+            target.clear(sf::Color::White);
+            boids.update(flock);
+            boids.draw(target);
+            target.display();
+            char what[64];
+            std::snprintf(what, sizeof(what), "N=%d frame %d: one draw call", n, frame);
+            check(boids.getDrawCallCount() == static_cast<std::size_t>(frame), what);
+            std::snprintf(what, sizeof(what), "N=%d: 6 vertices per boid", n);
+            check(boids.getVertices().getVertexCount() == BoidRenderer::verticesPerBoid * n, what);
+        }
+    }
+
+    // Half extents 8 x 4 around (100, 50). Facing +x the sprite is upright;
+    // at PI/2 it is turned clockwise on screen (y points down), so its top
+    // edge runs from (104, 42) down to (104, 58).
+    BoidRenderer boids(texture);
+    boids.update(oneBoid(100.f, 50.f, 0.f));
+    const sf::Vector2f upright[4] = { sf::Vector2f(92.f, 46.f), sf::Vector2f(108.f, 46.f),
+                                      sf::Vector2f(108.f, 54.f), sf::Vector2f(92.f, 54.f) };
+    checkQuad(boids.getVertices(), upright, 16.f, 8.f, "orientation 0");
+
+    boids.update(oneBoid(100.f, 50.f, PI / 2.f));
+    const sf::Vector2f turned[4] = { sf::Vector2f(104.f, 42.f), sf::Vector2f(104.f, 58.f),
+                                     sf::Vector2f(96.f, 58.f), sf::Vector2f(96.f, 42.f) };
+    checkQuad(boids.getVertices(), turned, 16.f, 8.f, "orientation PI/2");
+
+    // The pixel under the boid's center is covered by the texture.
+    target.clear(sf::Color::White);
+    boids.draw(target);
+    target.display();
+    sf::Image picture = target.getTexture().copyToImage();
+    check(picture.getPixel(100, 50) != sf::Color::White, "pixel under the boid is drawn");
+
+    std::printf("%s\n", failures == 0 ? "boid renderer: all checks passed" : "boid renderer: FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "FlockSimulation.hpp"
+
+// Self-check for the steering level of detail (SteeringLod.hpp), headless.
+// Prints each failure and exits non-zero if there was one.
+//
+//   ./test_steering_lod
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        std::printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// Runs a flock of randomly placed boids and returns its scheduler's counts.
+static SteeringLod runFlock(const FlockParams& params, const sf::FloatRect& view, int boids, int frames) {
+    FlockSimulation simulation(params, 1);
+    simulation.setView(view);
+    std::srand(1);
+    for (int i = 0; i < boids; ++i) {
+        Kinematic k;
+        k.position = sf::Vector2f(params.worldWidth * std::rand() / RAND_MAX,
+                                  params.worldHeight * std::rand() / RAND_MAX);
+        k.orientation = (std::rand() % 360) * (PI / 180.f);
+        k.velocity = sf::Vector2f(std::cos(k.orientation), std::sin(k.orientation)) * params.maxSpeed;
+        k.rotation = 0.f;
+        simulation.addBoid(k, 1);
+    }
+    for (int f = 0; f < frames; ++f)
+        simulation.step(1.f / 60.f);
+    return simulation.getLod();
+}
+
+// Share of agent-frames whose steering was recomputed, as reportLod prints it.
+static double updatedShare(const FlockParams& params, const sf::FloatRect& view, int boids, int frames) {
+    SteeringLod lod = runFlock(params, view, boids, frames);
+    return static_cast<double>(lod.getUpdateCount()) / lod.getAgentFrameCount();
+}
+
+// A view over the left half of the world leaves about half the boids off
+// screen; with offscreenInterval 4 they update a quarter as often, so the
+// share drops to about 5/8. Isolation is taken out with isolatedInterval 1.
+static void checkOffscreen() {
+    FlockParams params;
+    params.lod.enabled = true;
+    params.lod.isolatedInterval = 1;
+    const sf::FloatRect half(0.f, 0.f, params.worldWidth / 2.f, params.worldHeight);
+
+    params.lod.offscreenInterval = 1;
+    double everyFrame = updatedShare(params, half, 1000, 240);
+    params.lod.offscreenInterval = 4;
+    double culled = updatedShare(params, half, 1000, 240);
+    double wholeWorld = updatedShare(params, sf::FloatRect(0.f, 0.f, params.worldWidth, params.worldHeight),
+                                     1000, 240);
+    std::printf("offscreen: %.1f%% updated with interval 1, %.1f%% with 4 (whole-world view: %.1f%%)\n",
+                100.0 * everyFrame, 100.0 * culled, 100.0 * wholeWorld);
+    check(everyFrame > 0.999, "offscreenInterval 1 updates every boid every frame");
+    check(culled < 0.75 && culled > 0.5, "offscreenInterval 4 lowers the updated share to about 5/8");
+    check(wholeWorld > 0.999, "a whole-world view culls nothing");
+}
+
+// Morton sorting reorders the boids every sortInterval frames; phases keyed
+// on the spawn id keep every boid's longest gap between steering updates
+// within its interval, as without sorting. A sparse world under a tight
+// budget makes the intervals long (isolated boids, doubled by the budget).
+static void checkGapsUnderSorting() {
+    const int boids = 5000;
+    FlockParams params;
+    params.worldWidth = params.worldHeight = std::sqrt(boids / (100.f / (640.f * 480.f)));
+    params.lod.enabled = true;
+    params.lod.budget = 50;
+    const sf::FloatRect everything;
+
+    SteeringLod unsorted = runFlock(params, everything, boids, 1500);
+    params.sortInterval = 60;
+    SteeringLod sorted = runFlock(params, everything, boids, 1500);
+    std::printf("gaps: longest %llu frames unsorted, %llu sorted every 60 (longest interval %llu, %llu)\n",
+                static_cast<unsigned long long>(unsorted.getLongestGap()),
+                static_cast<unsigned long long>(sorted.getLongestGap()),
+                static_cast<unsigned long long>(unsorted.getLongestInterval()),
+                static_cast<unsigned long long>(sorted.getLongestInterval()));
+    check(unsorted.getLongestGap() <= unsorted.getLongestInterval(), "unsorted: no gap longer than the interval");
+    check(sorted.getLongestGap() <= sorted.getLongestInterval(), "sorted: no gap longer than the interval");
+}
+
+int main()
+{
+    checkOffscreen();
+    checkGapsUnderSorting();
+    std::printf("%s\n", failures == 0 ? "steering lod: all checks passed" : "steering lod: FAILED");
+    return failures == 0 ? 0 : 1;
+}